@@ -0,0 +1,91 @@
+#ifndef ADAPTIVE_WAIT_HPP
+#define ADAPTIVE_WAIT_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || \
+    defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace multithreading::pool {
+inline void CpuRelax() noexcept {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || \
+    defined(__i386__)
+  _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  asm volatile("yield");
+#endif
+}
+
+// Spin-then-park waiting. A waiter first spins with CpuRelax, then yields a
+// few times and only then parks. The spin budget follows the wake-up gaps the
+// waiter has seen recently: when work tends to show up within a few
+// microseconds it spins for about twice that long, so it is picked up without
+// a sleep/wake round trip; when the gaps are long it barely spins and parks
+// almost at once, so the core is not wasted. One core gives nothing to spin
+// for, so there the spin phase is skipped.
+class AdaptiveWait {
+ public:
+  static constexpr std::chrono::nanoseconds MIN_SPIN_DURATION{
+      std::chrono::microseconds{1}};
+  static constexpr std::chrono::nanoseconds MAX_SPIN_DURATION{
+      std::chrono::microseconds{50}};
+  static constexpr std::size_t YIELDS_COUNT{4ULL};
+
+  // Returns once ready() holds or park() has returned. park() has to block
+  // until ready() may hold; the caller re-checks its condition afterwards.
+  template <class Ready, class Park>
+  void Wait(Ready&& ready, Park&& park) {
+    auto const start_time{std::chrono::steady_clock::now()};
+    if (!Poll(ready, start_time)) {
+      park();
+    }
+    Record(std::chrono::steady_clock::now() - start_time);
+  }
+
+ private:
+  template <class Ready>
+  bool Poll(Ready& ready, std::chrono::steady_clock::time_point start_time) {
+    static constexpr std::size_t SPINS_PER_CLOCK_READ{64ULL};
+    if (IS_MULTICORE) {
+      for (std::size_t i{1ULL};; ++i) {
+        if (ready()) return true;
+        if (i % SPINS_PER_CLOCK_READ == 0ULL &&
+            std::chrono::steady_clock::now() - start_time >= spin_budget_) {
+          break;
+        }
+        CpuRelax();
+      }
+    }
+    for (std::size_t i{0ULL}; i < YIELDS_COUNT; ++i) {
+      if (ready()) return true;
+      std::this_thread::yield();
+    }
+    return ready();
+  }
+
+  void Record(std::chrono::nanoseconds gap) noexcept {
+    // A long sleep only has to say "do not spin"; capping it lets the budget
+    // recover after a few short gaps.
+    gap = std::min(gap, 2 * MAX_SPIN_DURATION);
+    avg_gap_ = avg_gap_.count() == 0 ? gap : avg_gap_ + (gap - avg_gap_) / 8;
+    spin_budget_ = avg_gap_ <= MAX_SPIN_DURATION
+                       ? std::clamp(2 * avg_gap_, MIN_SPIN_DURATION,
+                                    MAX_SPIN_DURATION)
+                       : MIN_SPIN_DURATION;
+  }
+
+ private:
+  static inline bool const IS_MULTICORE{std::thread::hardware_concurrency() >
+                                        1U};
+
+  std::chrono::nanoseconds avg_gap_{};
+  std::chrono::nanoseconds spin_budget_{MIN_SPIN_DURATION};
+};
+}  // namespace multithreading::pool
+
+#endif  // !ADAPTIVE_WAIT_HPP
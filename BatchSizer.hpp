@@ -0,0 +1,52 @@
+#ifndef BATCH_SIZER_HPP
+#define BATCH_SIZER_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+
+namespace multithreading::pool {
+// Decides how many tasks a slave takes from a shared queue per trip. Short
+// tasks are taken in batches so that the trip cost is amortised; the batch is
+// capped by the queue depth, so that one slave never hoards work the others
+// could run, and by the observed task duration, so that a batch of heavy
+// tasks never stalls in one slave's private buffer.
+class BatchSizer {
+ public:
+  static constexpr std::size_t MAX_BATCH_SIZE{64ULL};
+  static constexpr std::chrono::nanoseconds TARGET_BATCH_DURATION{
+      std::chrono::microseconds{50}};
+
+  std::size_t Next(std::ptrdiff_t queue_depth,
+                   std::size_t slaves_count) const noexcept {
+    if (queue_depth <= 0) return 1ULL;
+
+    auto const by_depth{static_cast<std::size_t>(queue_depth) /
+                        (std::size_t{2} * std::max(slaves_count, std::size_t{1}))};
+    auto const by_duration{
+        avg_task_duration_.count() > 0
+            ? static_cast<std::size_t>(TARGET_BATCH_DURATION /
+                                       avg_task_duration_)
+            : MAX_BATCH_SIZE};
+    return std::clamp(std::min(by_depth, by_duration), std::size_t{1},
+                      MAX_BATCH_SIZE);
+  }
+
+  void Record(std::size_t tasks_count,
+              std::chrono::nanoseconds elapsed) noexcept {
+    if (tasks_count == 0ULL) return;
+
+    // Exponential moving average with a weight of 1/8 for the new sample.
+    auto const per_task{elapsed / static_cast<long long>(tasks_count)};
+    avg_task_duration_ = avg_task_duration_.count() == 0
+                             ? per_task
+                             : avg_task_duration_ +
+                                   (per_task - avg_task_duration_) / 8;
+  }
+
+ private:
+  std::chrono::nanoseconds avg_task_duration_{};
+};
+}  // namespace multithreading::pool
+
+#endif  // !BATCH_SIZER_HPP
@@ -0,0 +1,144 @@
+#ifndef BLOCK_CACHE_HPP
+#define BLOCK_CACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace multithreading::memory {
+// Per-thread free list of memory blocks of one size. Every block remembers
+// the cache of the thread that allocated it and goes back there when freed:
+// straight onto its own list, up to CAPACITY blocks, if the owner frees it,
+// onto a lock-free list that the owner takes over in one go once its own
+// list runs dry otherwise. A thread that keeps allocating blocks that other
+// threads free thus reuses them instead of calling operator new again. A
+// cache outlives its thread until the last of its blocks is freed.
+template <std::size_t BLOCK_SIZE, std::size_t BLOCK_ALIGNMENT,
+          std::size_t CAPACITY>
+class BlockCache {
+ public:
+  static void* Allocate() {
+    auto* const local{Local().cache};
+    if (local == nullptr) {
+      auto* const block{::operator new(ALLOCATION_SIZE,
+                                       std::align_val_t{BLOCK_ALIGNMENT})};
+      Owner(block) = nullptr;
+      return block;
+    }
+
+    auto& cache{*local};
+    if (cache.head_ == nullptr) {
+      cache.head_ = cache.returned_head_.exchange(nullptr,
+                                                  std::memory_order_acquire);
+    }
+    if (cache.head_ != nullptr) {
+      if (cache.count_ > 0ULL) --cache.count_;
+      return std::exchange(cache.head_, cache.head_->next);
+    }
+
+    cache.refs_.fetch_add(1ULL, std::memory_order_relaxed);
+    auto* const block{::operator new(ALLOCATION_SIZE,
+                                     std::align_val_t{BLOCK_ALIGNMENT})};
+    Owner(block) = &cache;
+    return block;
+  }
+
+  static void Deallocate(void* block) noexcept {
+    auto* const owner{Owner(block)};
+    if (owner == nullptr) {
+      ::operator delete(block, std::align_val_t{BLOCK_ALIGNMENT});
+      return;
+    }
+    if (owner == Local().cache) {
+      if (owner->count_ < CAPACITY) {
+        owner->head_ = ::new (block) FreeBlock{owner->head_};
+        ++owner->count_;
+      } else {
+        owner->Free(block);
+      }
+      return;
+    }
+
+    // The block keeps its owner alive until it is on the returned list.
+    auto* const free_block{::new (block) FreeBlock{nullptr}};
+    auto* head{owner->returned_head_.load(std::memory_order_relaxed)};
+    do {
+      if (head == Orphaned()) {
+        owner->Free(block);
+        return;
+      }
+      free_block->next = head;
+    } while (!owner->returned_head_.compare_exchange_weak(
+        head, free_block, std::memory_order_release,
+        std::memory_order_relaxed));
+  }
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  static_assert(BLOCK_SIZE >= sizeof(FreeBlock));
+
+  // The owner is stored right after the block.
+  static constexpr std::size_t OWNER_OFFSET{
+      (BLOCK_SIZE + alignof(BlockCache*) - 1ULL) / alignof(BlockCache*) *
+      alignof(BlockCache*)};
+  static constexpr std::size_t ALLOCATION_SIZE{OWNER_OFFSET +
+                                               sizeof(BlockCache*)};
+
+  // Ends the life of the cache of the thread it belongs to. Blocks still
+  // allocated by that thread afterwards, e.g. from destructors of other
+  // thread_local objects, have no owner.
+  struct LocalHandle {
+    ~LocalHandle() { std::exchange(cache, nullptr)->Orphan(); }
+
+    BlockCache* cache{new BlockCache{}};
+  };
+
+  static BlockCache*& Owner(void* block) noexcept {
+    return *std::launder(reinterpret_cast<BlockCache**>(
+        static_cast<std::byte*>(block) + OWNER_OFFSET));
+  }
+
+  // Stands for the head of the returned blocks once the thread is gone.
+  static FreeBlock* Orphaned() noexcept { return &orphaned_; }
+
+  static LocalHandle& Local() noexcept {
+    thread_local LocalHandle handle{};
+    return handle;
+  }
+
+  void Orphan() noexcept {
+    auto* returned{
+        returned_head_.exchange(Orphaned(), std::memory_order_acquire)};
+    while (returned != nullptr) {
+      Free(std::exchange(returned, returned->next));
+    }
+    while (head_ != nullptr) {
+      Free(std::exchange(head_, head_->next));
+    }
+    Release();
+  }
+
+  void Free(void* block) noexcept {
+    ::operator delete(block, std::align_val_t{BLOCK_ALIGNMENT});
+    Release();
+  }
+
+  // One reference per block alive, one for the thread.
+  void Release() noexcept {
+    if (refs_.fetch_sub(1ULL, std::memory_order_acq_rel) == 1ULL) delete this;
+  }
+
+  static inline FreeBlock orphaned_{nullptr};
+
+  FreeBlock* head_{nullptr};
+  std::size_t count_{0ULL};
+  std::atomic<std::size_t> refs_{1ULL};
+  alignas(64) std::atomic<FreeBlock*> returned_head_{nullptr};
+};
+}  // namespace multithreading::memory
+
+#endif  // !BLOCK_CACHE_HPP
@@ -0,0 +1,121 @@
+#ifndef CO_TASK_HPP
+#define CO_TASK_HPP
+
+#include "SharedState.hpp"
+#include "multithreading_pool_stealing.hpp"
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+namespace multithreading::pool::stealing {
+namespace details {
+template <class T>
+struct CoTaskPromiseBase {
+  template <class R>
+  void return_value(R&& val) noexcept {
+    result.Set(std::forward<R>(val));
+  }
+
+  futurama::Promise<T> result{};
+};
+
+template <>
+struct CoTaskPromiseBase<void> {
+  void return_void() noexcept { result.Set(); }
+
+  futurama::Promise<void> result{};
+};
+
+// Suspends the awaiting coroutine until future is ready, then resumes it on
+// resume_on, so neither the awaiting worker nor the one that made the future
+// ready is held meanwhile.
+template <class T>
+class FutureAwaiter {
+ public:
+  FutureAwaiter(futurama::Future<T> future_init, Master& resume_on_init)
+      : future_{std::move(future_init)}, resume_on_{resume_on_init} {}
+
+  bool await_ready() const noexcept { return future_.IsReady(); }
+
+  // The coroutine may be resumed before this returns; nothing in the frame is
+  // touched after OnReady.
+  void await_suspend(std::coroutine_handle<> awaiter) {
+    future_.OnReady([&resume_on = resume_on_, awaiter] {
+      resume_on.Post([awaiter] { awaiter.resume(); });
+    });
+  }
+
+  T await_resume() { return future_.Get(); }
+
+ private:
+  futurama::Future<T> future_;
+  Master& resume_on_;
+};
+}  // namespace details
+
+// Eagerly scheduled coroutine: its body starts on the async queue of the
+// current executer, and every co_await on a CoTask, CoRunAsyncTask or
+// CoRunProcessTask resumes it there. The frame destroys itself once the body
+// is done; the result is kept by the CoTask, which can also be Get-ed from a
+// thread outside the pools.
+template <class T>
+class [[nodiscard]] CoTask {
+ public:
+  struct promise_type : details::CoTaskPromiseBase<T> {
+    CoTask get_return_object() { return CoTask{this->result.GetFuture()}; }
+
+    auto initial_suspend() noexcept {
+      struct ScheduleAwaiter {
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> self) {
+          ThisExecuter().async_queue.Post([self] { self.resume(); });
+        }
+        void await_resume() const noexcept {}
+      };
+      return ScheduleAwaiter{};
+    }
+
+    std::suspend_never final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() noexcept {
+      this->result.SetException(std::current_exception());
+    }
+  };
+
+  T Get() { return future_.Get(); }
+
+  bool IsReady() const noexcept { return future_.IsReady(); }
+
+  auto operator co_await() && {
+    return details::FutureAwaiter<T>{std::move(future_),
+                                     ThisExecuter().async_queue};
+  }
+
+ private:
+  explicit CoTask(futurama::Future<T> future_init)
+      : future_{std::move(future_init)} {}
+
+  futurama::Future<T> future_;
+};
+
+template <class F, typename... Args>
+inline auto CoRunAsyncTask(F&& functor, Args&&... params) {
+  auto& executer{ThisExecuter()};
+  return details::FutureAwaiter{
+      futurama::Async(executer.async_queue, std::forward<F>(functor),
+                      std::forward<Args>(params)...),
+      executer.async_queue};
+}
+
+template <class F, typename... Args>
+inline auto CoRunProcessTask(F&& functor, Args&&... params) {
+  auto& executer{ThisExecuter()};
+  return details::FutureAwaiter{
+      futurama::Async(executer.process_queue, std::forward<F>(functor),
+                      std::forward<Args>(params)...),
+      executer.async_queue};
+}
+}  // namespace multithreading::pool::stealing
+
+#endif  // !CO_TASK_HPP
@@ -0,0 +1,208 @@
+#ifndef COMPLETION_QUEUE_HPP
+#define COMPLETION_QUEUE_HPP
+
+#include "SharedState.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace multithreading::pool {
+// Results of tasks in the order they finish, each tagged with the index the
+// task was submitted under, for a single consumer to drain while the rest
+// are still running. Producers take a slot with one fetch_add on a ring laid
+// out like lockfree::RingQueue, the consumer takes it back without any
+// read-modify-write. A producer that finds the ring full does not wait for
+// the consumer: it spills the result to an overflow list under a lock,
+// which the consumer takes over whenever the ring runs dry.
+template <class T>
+class CompletionQueue {
+ public:
+  struct Completion {
+    // Returns the result of the task or rethrows its exception.
+    T Get() {
+      if (auto const e{std::get_if<std::exception_ptr>(&result)}) {
+        std::rethrow_exception(*e);
+      }
+      return std::move(std::get<T>(result));
+    }
+
+    std::size_t index;
+    std::variant<T, std::exception_ptr> result;
+  };
+
+  static constexpr std::size_t DEFAULT_CAPACITY{1ULL << 12};
+
+  explicit CompletionQueue(std::size_t capacity = DEFAULT_CAPACITY)
+      : mask_{std::bit_ceil(std::max(capacity, std::size_t{2})) - 1ULL},
+        cells_{std::make_unique<Cell[]>(mask_ + 1ULL)} {
+    for (std::size_t i{0ULL}; i <= mask_; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  CompletionQueue(CompletionQueue const&) = delete;
+  CompletionQueue& operator=(CompletionQueue const&) = delete;
+
+  // Posts functor(params...), or the exception it throws, under index.
+  template <class F, typename... Args>
+  void PushFrom(std::size_t index, F&& functor, Args&&... params) noexcept {
+    try {
+      Push({index, std::invoke(std::forward<F>(functor),
+                               std::forward<Args>(params)...)});
+    } catch (...) {
+      Push({index, std::current_exception()});
+    }
+  }
+
+  // Any thread may push; never blocks on the consumer. Once the sequence is
+  // published the queue may be gone already, so the consumer's parked flag
+  // comes back from that very exchange and only the address is used
+  // afterwards.
+  void Push(Completion&& completion) noexcept {
+    auto pos{enqueue_pos_.load(std::memory_order_relaxed)};
+    Cell* cell{};
+    while (true) {
+      cell = &cells_[pos & mask_];
+      auto const seq{cell->sequence.load(std::memory_order_acquire) &
+                     ~PARKED};
+      auto const diff{static_cast<std::ptrdiff_t>(seq) -
+                      static_cast<std::ptrdiff_t>(pos)};
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1ULL,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        Spill(std::move(completion));
+        return;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->value.emplace(std::move(completion));
+    if ((cell->sequence.exchange(pos + 1ULL, std::memory_order_acq_rel) &
+         PARKED) != 0ULL) {
+      cell->sequence.notify_one();
+    }
+  }
+
+  // Consumer only.
+  std::optional<Completion> TryPop() {
+    auto& cell{cells_[dequeue_pos_ & mask_]};
+    if (cell.sequence.load(std::memory_order_acquire) == dequeue_pos_ + 1ULL) {
+      std::optional<Completion> completion{std::move(cell.value)};
+      cell.value.reset();
+      cell.sequence.store(dequeue_pos_ + mask_ + 1ULL,
+                          std::memory_order_release);
+      ++dequeue_pos_;
+      return completion;
+    }
+
+    if (spilled_.empty() &&
+        overflow_count_.load(std::memory_order_relaxed) != 0ULL) {
+      std::lock_guard lock{overflow_mtx_};
+      spilled_.swap(overflow_);
+      overflow_count_.store(0ULL, std::memory_order_relaxed);
+    }
+    if (spilled_.empty()) return std::nullopt;
+
+    std::optional<Completion> completion{std::move(spilled_.back())};
+    spilled_.pop_back();
+    return completion;
+  }
+
+  // Consumer only; appends up to max_count completions to out.
+  std::size_t TryPopBulk(std::vector<Completion>& out, std::size_t max_count) {
+    std::size_t count{0ULL};
+    while (count < max_count) {
+      auto completion{TryPop()};
+      if (!completion) break;
+      out.push_back(std::move(*completion));
+      ++count;
+    }
+    return count;
+  }
+
+  // Consumer only; blocks until the next completion is in, letting the
+  // thread's futurama::BlockingObserver know about it.
+  Completion Pop() {
+    while (true) {
+      if (auto completion{TryPop()}) return std::move(*completion);
+
+      // The free cell is flagged as parked on with a CAS, which fails if
+      // the producer has filled it in the meantime. A spill that comes in
+      // after the check below finds the cell through parked_pos_ and clears
+      // the flag itself.
+      auto& cell{cells_[dequeue_pos_ & mask_]};
+      auto free_sequence{dequeue_pos_};
+      parked_pos_.store(dequeue_pos_);
+      if (!cell.sequence.compare_exchange_strong(free_sequence,
+                                                 dequeue_pos_ | PARKED)) {
+        continue;
+      }
+      if (overflow_count_.load() != 0ULL) {
+        auto parked_sequence{dequeue_pos_ | PARKED};
+        cell.sequence.compare_exchange_strong(parked_sequence, dequeue_pos_);
+        continue;
+      }
+      auto* const observer{futurama::ThisThreadObserver()};
+      if (observer != nullptr) observer->BlockingStarted();
+      cell.sequence.wait(dequeue_pos_ | PARKED);
+      if (observer != nullptr) observer->BlockingFinished();
+    }
+  }
+
+  std::size_t Capacity() const noexcept { return mask_ + 1ULL; }
+
+ private:
+  struct alignas(64) Cell {
+    std::atomic<std::size_t> sequence{};
+    std::optional<Completion> value{};
+  };
+
+  // Set in the sequence of the free cell the consumer is parked on.
+  static constexpr std::size_t PARKED{
+      1ULL << (std::numeric_limits<std::size_t>::digits - 1)};
+
+  // The queue stays alive while the lock is held, since the consumer needs
+  // it to get at the spilled result.
+  void Spill(Completion&& completion) noexcept {
+    std::lock_guard lock{overflow_mtx_};
+    overflow_.push_back(std::move(completion));
+    overflow_count_.fetch_add(1ULL);
+
+    auto const parked_pos{parked_pos_.load()};
+    auto& cell{cells_[parked_pos & mask_]};
+    auto parked_sequence{parked_pos | PARKED};
+    if (cell.sequence.compare_exchange_strong(parked_sequence, parked_pos)) {
+      cell.sequence.notify_one();
+    }
+  }
+
+  std::size_t const mask_;
+  std::unique_ptr<Cell[]> const cells_;
+
+  alignas(64) std::atomic<std::size_t> enqueue_pos_{0ULL};
+  alignas(64) std::size_t dequeue_pos_{0ULL};
+  // Consumer only; spilled results taken over from overflow_.
+  std::vector<Completion> spilled_{};
+  std::atomic<std::size_t> parked_pos_{0ULL};
+
+  alignas(64) std::mutex overflow_mtx_{};
+  std::vector<Completion> overflow_{};
+  std::atomic<std::size_t> overflow_count_{0ULL};
+};
+}  // namespace multithreading::pool
+
+#endif  // !COMPLETION_QUEUE_HPP
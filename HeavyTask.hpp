@@ -6,6 +6,7 @@
 class HeavyTask : public Task {
  public:
   static constexpr std::size_t ITERATIONS_COUNT{5'000ULL};
+  static constexpr std::size_t OPERATIONS_PER_ITERATION{8ULL};
 
   DUMMY_OUTPUT do_stuff() const override {
     auto result{val};
@@ -21,6 +22,10 @@ class HeavyTask : public Task {
     }
     return static_cast<DUMMY_OUTPUT>(std::round(result)) % 100;
   }
+
+  std::size_t get_estimated_cost() const noexcept override {
+    return ITERATIONS_COUNT * OPERATIONS_PER_ITERATION;
+  }
 };
 
 #endif  // !HEAVY_TASK_HPP
\ No newline at end of file
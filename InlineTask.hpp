@@ -0,0 +1,158 @@
+#ifndef INLINE_TASK_HPP
+#define INLINE_TASK_HPP
+
+#include "BlockCache.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace multithreading::pool {
+// Oversized callables of every size class are kept per thread for reuse, up to
+// this many.
+inline constexpr std::size_t ARENA_CACHE_CAPACITY{256ULL};
+
+// Whether F is stored right in the buffer of a task. Specialise it to force a
+// callable into the arena.
+template <class F, std::size_t BUFFER_SIZE>
+struct FitsInline
+    : std::bool_constant<sizeof(F) <= BUFFER_SIZE &&
+                         alignof(F) <= alignof(std::max_align_t) &&
+                         std::is_nothrow_move_constructible_v<F>> {};
+
+// Move-only void() callable occupying SIZE bytes, a whole number of cache
+// lines, so that neighbouring tasks in a queue never share one. Callables up
+// to BUFFER_SIZE are kept inline; bigger ones go to a block of their size
+// class taken from a per-thread memory::BlockCache, so once the caches are
+// warm no task allocates.
+template <std::size_t SIZE>
+class alignas(64) BasicInlineTask {
+  static_assert(SIZE >= 64ULL && SIZE % 64ULL == 0ULL);
+
+ public:
+  static constexpr std::size_t BUFFER_SIZE{SIZE - alignof(std::max_align_t)};
+
+  BasicInlineTask() = default;
+
+  template <class F>
+    requires(!std::same_as<std::remove_cvref_t<F>, BasicInlineTask> &&
+             std::invocable<std::decay_t<F>&>)
+  BasicInlineTask(F&& functor) {
+    using functor_t = std::decay_t<F>;
+    if constexpr (FitsInline<functor_t, BUFFER_SIZE>::value) {
+      ::new (static_cast<void*>(buffer_)) functor_t(std::forward<F>(functor));
+      ops_ = &INLINE_OPERATIONS<functor_t>;
+    } else {
+      auto const block{Arena<functor_t>::Allocate()};
+      functor_t* stored{nullptr};
+      try {
+        stored = ::new (block) functor_t(std::forward<F>(functor));
+      } catch (...) {
+        Arena<functor_t>::Deallocate(block);
+        throw;
+      }
+      ::new (static_cast<void*>(buffer_)) functor_t*{stored};
+      ops_ = &ARENA_OPERATIONS<functor_t>;
+    }
+  }
+
+  BasicInlineTask(BasicInlineTask&& other) noexcept
+      : ops_{std::exchange(other.ops_, nullptr)} {
+    if (ops_ != nullptr) ops_->relocate(buffer_, other.buffer_);
+  }
+
+  BasicInlineTask& operator=(BasicInlineTask&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      ops_ = std::exchange(other.ops_, nullptr);
+      if (ops_ != nullptr) ops_->relocate(buffer_, other.buffer_);
+    }
+    return *this;
+  }
+
+  BasicInlineTask(BasicInlineTask const&) = delete;
+  BasicInlineTask& operator=(BasicInlineTask const&) = delete;
+
+  ~BasicInlineTask() { Reset(); }
+
+  void operator()() { ops_->invoke(buffer_); }
+
+  explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+  // Tasks that the pools keep on the heap come from a per-thread cache too.
+  static void* operator new(std::size_t) {
+    return memory::BlockCache<sizeof(BasicInlineTask), alignof(BasicInlineTask),
+                              ARENA_CACHE_CAPACITY>::Allocate();
+  }
+  static void operator delete(void* block) noexcept {
+    memory::BlockCache<sizeof(BasicInlineTask), alignof(BasicInlineTask),
+                       ARENA_CACHE_CAPACITY>::Deallocate(block);
+  }
+
+ private:
+  struct Operations {
+    void (*invoke)(std::byte* buffer);
+    // Moves the callable from src to the uninitialised dst and destroys the
+    // source.
+    void (*relocate)(std::byte* dst, std::byte* src) noexcept;
+    void (*destroy)(std::byte* buffer) noexcept;
+  };
+
+  template <class F>
+  using Arena = memory::BlockCache<
+      std::bit_ceil(std::max(sizeof(F), std::size_t{64})),
+      std::max(alignof(F), alignof(std::max_align_t)), ARENA_CACHE_CAPACITY>;
+
+  template <class F>
+  static F& Inline(std::byte* buffer) noexcept {
+    return *std::launder(reinterpret_cast<F*>(buffer));
+  }
+
+  template <class F>
+  static F*& InArena(std::byte* buffer) noexcept {
+    return *std::launder(reinterpret_cast<F**>(buffer));
+  }
+
+  template <class F>
+  static constexpr Operations INLINE_OPERATIONS{
+      [](std::byte* buffer) { std::invoke(Inline<F>(buffer)); },
+      [](std::byte* dst, std::byte* src) noexcept {
+        ::new (static_cast<void*>(dst)) F(std::move(Inline<F>(src)));
+        std::destroy_at(&Inline<F>(src));
+      },
+      [](std::byte* buffer) noexcept { std::destroy_at(&Inline<F>(buffer)); }};
+
+  template <class F>
+  static constexpr Operations ARENA_OPERATIONS{
+      [](std::byte* buffer) { std::invoke(*InArena<F>(buffer)); },
+      [](std::byte* dst, std::byte* src) noexcept {
+        ::new (static_cast<void*>(dst)) F*{InArena<F>(src)};
+      },
+      [](std::byte* buffer) noexcept {
+        auto const functor{InArena<F>(buffer)};
+        std::destroy_at(functor);
+        Arena<F>::Deallocate(functor);
+      }};
+
+  void Reset() noexcept {
+    if (auto const ops{std::exchange(ops_, nullptr)}) {
+      ops->destroy(buffer_);
+    }
+  }
+
+  alignas(std::max_align_t) std::byte buffer_[BUFFER_SIZE];
+  Operations const* ops_{nullptr};
+};
+
+inline constexpr std::size_t DEFAULT_TASK_SIZE{128ULL};
+using InlineTask = BasicInlineTask<DEFAULT_TASK_SIZE>;
+static_assert(sizeof(InlineTask) == DEFAULT_TASK_SIZE);
+}  // namespace multithreading::pool
+
+#endif  // !INLINE_TASK_HPP
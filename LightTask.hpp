@@ -6,6 +6,7 @@
 class LightTask : public Task {
  public:
   static constexpr std::size_t ITERATIONS_COUNT{25ULL};
+  static constexpr std::size_t OPERATIONS_PER_ITERATION{3ULL};
   DUMMY_OUTPUT do_stuff() const override {
     auto result{val};
     for (std::size_t i{0ULL}; i < ITERATIONS_COUNT; ++i) {
@@ -15,5 +16,9 @@ class LightTask : public Task {
     }
     return static_cast<DUMMY_OUTPUT>(std::round(result)) % 100;
   }
+
+  std::size_t get_estimated_cost() const noexcept override {
+    return ITERATIONS_COUNT * OPERATIONS_PER_ITERATION;
+  }
 };
 #endif  // !LIGHT_TASK_HPP
\ No newline at end of file
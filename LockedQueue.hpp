@@ -0,0 +1,73 @@
+#ifndef LOCKED_QUEUE_HPP
+#define LOCKED_QUEUE_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace multithreading::pool {
+// Unbounded FIFO behind a mutex. Items live in a circular buffer that only
+// ever grows, so a queue that has reached its working size stops allocating.
+template <class T>
+class LockedQueue {
+ public:
+  static constexpr std::size_t INITIAL_CAPACITY{64ULL};
+
+  std::size_t TryPushBulk(std::span<T> items) {
+    std::lock_guard lk{mtx_};
+    Reserve(size_ + items.size());
+    for (auto& item : items) {
+      slots_[(head_ + size_) & (slots_.size() - 1ULL)] = std::move(item);
+      ++size_;
+    }
+    return items.size();
+  }
+
+  std::size_t TryPopBulk(std::vector<T>& out, std::size_t max_count) {
+    std::lock_guard lk{mtx_};
+    auto const count{std::min(max_count, size_)};
+    for (std::size_t i{0ULL}; i < count; ++i) {
+      out.push_back(PopFront());
+    }
+    return count;
+  }
+
+  std::optional<T> TryPop() {
+    std::lock_guard lk{mtx_};
+    if (size_ == 0ULL) return std::nullopt;
+    return PopFront();
+  }
+
+ private:
+  T PopFront() {
+    auto item{std::move(slots_[head_])};
+    slots_[head_] = T{};
+    head_ = (head_ + 1ULL) & (slots_.size() - 1ULL);
+    --size_;
+    return item;
+  }
+
+  void Reserve(std::size_t capacity) {
+    if (capacity <= slots_.size()) return;
+
+    std::vector<T> slots(std::bit_ceil(std::max(capacity, INITIAL_CAPACITY)));
+    for (std::size_t i{0ULL}; i < size_; ++i) {
+      slots[i] = std::move(slots_[(head_ + i) & (slots_.size() - 1ULL)]);
+    }
+    slots_ = std::move(slots);
+    head_ = 0ULL;
+  }
+
+  std::vector<T> slots_{};
+  std::size_t head_{0ULL};
+  std::size_t size_{0ULL};
+  std::mutex mtx_{};
+};
+}  // namespace multithreading::pool
+
+#endif  // !LOCKED_QUEUE_HPP
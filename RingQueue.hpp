@@ -0,0 +1,176 @@
+#ifndef RING_QUEUE_HPP
+#define RING_QUEUE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace multithreading::lockfree {
+// Bounded multi-producer/multi-consumer queue after D. Vyukov's design: every
+// slot carries a sequence number telling whether it is free for the producer
+// of the current lap or filled for the consumer of the current lap, so a
+// push or a pop is one CAS on the corresponding cursor.
+template <class T>
+class RingQueue {
+ private:
+  struct alignas(64) Cell {
+    std::atomic<std::size_t> sequence{};
+    std::optional<T> value{};
+  };
+
+ public:
+  // A cell takes a cache line or more, so the default stays small; a full
+  // queue only makes TryPush fail.
+  static constexpr std::size_t DEFAULT_CAPACITY{1ULL << 10};
+
+  explicit RingQueue(std::size_t capacity = DEFAULT_CAPACITY)
+      : mask_{std::bit_ceil(std::max(capacity, std::size_t{2})) - 1ULL},
+        cells_{std::make_unique<Cell[]>(mask_ + 1ULL)} {
+    for (std::size_t i{0ULL}; i <= mask_; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  RingQueue(RingQueue const&) = delete;
+  RingQueue& operator=(RingQueue const&) = delete;
+
+  // Leaves item untouched when the queue is full.
+  bool TryPush(T&& item) {
+    auto pos{enqueue_pos_.load(std::memory_order_relaxed)};
+    Cell* cell{};
+    while (true) {
+      cell = &cells_[pos & mask_];
+      auto const seq{cell->sequence.load(std::memory_order_acquire)};
+      auto const diff{static_cast<std::ptrdiff_t>(seq) -
+                      static_cast<std::ptrdiff_t>(pos)};
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1ULL,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->value.emplace(std::move(item));
+    cell->sequence.store(pos + 1ULL, std::memory_order_release);
+    return true;
+  }
+
+  // Claims as many consecutive free slots as items needs (or as are free)
+  // with a single CAS, then fills them; returns how many items were moved in.
+  std::size_t TryPushBulk(std::span<T> items) {
+    if (items.empty()) return 0ULL;
+
+    auto pos{enqueue_pos_.load(std::memory_order_relaxed)};
+    std::size_t claimed{0ULL};
+    while (true) {
+      claimed = 0ULL;
+      while (claimed < items.size() &&
+             cells_[(pos + claimed) & mask_].sequence.load(
+                 std::memory_order_acquire) == pos + claimed) {
+        ++claimed;
+      }
+      if (claimed == 0ULL) {
+        auto const seq{
+            cells_[pos & mask_].sequence.load(std::memory_order_acquire)};
+        if (static_cast<std::ptrdiff_t>(seq) -
+                static_cast<std::ptrdiff_t>(pos) <
+            0) {
+          return 0ULL;
+        }
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      } else if (enqueue_pos_.compare_exchange_weak(
+                     pos, pos + claimed, std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    for (std::size_t i{0ULL}; i < claimed; ++i) {
+      auto& cell{cells_[(pos + i) & mask_]};
+      cell.value.emplace(std::move(items[i]));
+      cell.sequence.store(pos + i + 1ULL, std::memory_order_release);
+    }
+    return claimed;
+  }
+
+  std::optional<T> TryPop() {
+    auto pos{dequeue_pos_.load(std::memory_order_relaxed)};
+    Cell* cell{};
+    while (true) {
+      cell = &cells_[pos & mask_];
+      auto const seq{cell->sequence.load(std::memory_order_acquire)};
+      auto const diff{static_cast<std::ptrdiff_t>(seq) -
+                      static_cast<std::ptrdiff_t>(pos + 1ULL)};
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1ULL,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return std::nullopt;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    std::optional<T> item{std::move(cell->value)};
+    cell->value.reset();
+    cell->sequence.store(pos + mask_ + 1ULL, std::memory_order_release);
+    return item;
+  }
+
+  // Claims up to max_count consecutive filled slots with a single CAS and
+  // appends their items to out; returns how many items were taken.
+  std::size_t TryPopBulk(std::vector<T>& out, std::size_t max_count) {
+    if (max_count == 0ULL) return 0ULL;
+
+    auto pos{dequeue_pos_.load(std::memory_order_relaxed)};
+    std::size_t claimed{0ULL};
+    while (true) {
+      claimed = 0ULL;
+      while (claimed < max_count &&
+             cells_[(pos + claimed) & mask_].sequence.load(
+                 std::memory_order_acquire) == pos + claimed + 1ULL) {
+        ++claimed;
+      }
+      if (claimed == 0ULL) {
+        auto const seq{
+            cells_[pos & mask_].sequence.load(std::memory_order_acquire)};
+        if (static_cast<std::ptrdiff_t>(seq) -
+                static_cast<std::ptrdiff_t>(pos + 1ULL) <
+            0) {
+          return 0ULL;
+        }
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      } else if (dequeue_pos_.compare_exchange_weak(
+                     pos, pos + claimed, std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    for (std::size_t i{0ULL}; i < claimed; ++i) {
+      auto& cell{cells_[(pos + i) & mask_]};
+      out.push_back(std::move(*cell.value));
+      cell.value.reset();
+      cell.sequence.store(pos + i + mask_ + 1ULL, std::memory_order_release);
+    }
+    return claimed;
+  }
+
+  std::size_t Capacity() const noexcept { return mask_ + 1ULL; }
+
+ private:
+  std::size_t const mask_;
+  std::unique_ptr<Cell[]> const cells_;
+
+  alignas(64) std::atomic<std::size_t> enqueue_pos_{0ULL};
+  alignas(64) std::atomic<std::size_t> dequeue_pos_{0ULL};
+};
+}  // namespace multithreading::lockfree
+
+#endif  // !RING_QUEUE_HPP
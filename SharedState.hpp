@@ -1,22 +1,242 @@
 #ifndef SHARED_STATE_HPP
 #define SHARED_STATE_HPP
 
-#include <optional>
-#include <semaphore>
+#include "BlockCache.hpp"
+#include "InlineTask.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <ranges>
+#include <stop_token>
+#include <type_traits>
+#include <utility>
 #include <variant>
 
 namespace multithreading::futurama {
+// Freed shared states of every type are kept per thread for reuse, up to this
+// many; 0 turns the pooling off.
+inline constexpr std::size_t STATE_CACHE_CAPACITY{256ULL};
+
+// Anything tasks can be posted to, e.g. pool::generic::Master or
+// pool::stealing::Master.
+template <class S>
+concept Scheduler = requires(S& scheduler, std::move_only_function<void()> f) {
+  scheduler.Post(std::move(f));
+};
+
+// Lets a scheduler know that one of its threads is about to block in
+// Future::Get or Future::Wait, so that it can lend itself another thread for
+// the time being.
+class BlockingObserver {
+ public:
+  virtual void BlockingStarted() noexcept = 0;
+  virtual void BlockingFinished() noexcept = 0;
+
+ protected:
+  ~BlockingObserver() = default;
+};
+
+// The observer of the calling thread, nullptr by default.
+inline BlockingObserver*& ThisThreadObserver() noexcept {
+  thread_local BlockingObserver* observer{nullptr};
+  return observer;
+}
+
+// Stored in a future whose task was dropped instead of run.
+class TaskCancelled : public std::exception {
+ public:
+  char const* what() const noexcept override { return "task cancelled"; }
+};
+
+// When a task that has not started yet is to be dropped: once stop_token is
+// stopped or deadline has passed. The same stop_token may be shared by a
+// whole group of tasks; a task that takes a std::stop_token as its first
+// argument gets it, to give up cooperatively once it is running.
+struct Cancellation {
+  using CLOCK = std::chrono::steady_clock;
+
+  std::stop_token stop_token{};
+  CLOCK::time_point deadline{CLOCK::time_point::max()};
+
+  bool IsDue() const noexcept {
+    return stop_token.stop_requested() ||
+           (deadline != CLOCK::time_point::max() && CLOCK::now() >= deadline);
+  }
+};
+
+namespace details {
+// Continuations are small-buffer tasks of a single cache line, so that
+// registering one does not allocate either.
+using CALLBACK = pool::BasicInlineTask<64ULL>;
+
+struct Continuation {
+  CALLBACK callback{};
+  Continuation* next{nullptr};
+};
+
+// Readiness and the continuations of a shared state, kept as an intrusive
+// stack whose head Set swaps for a READY mark. A continuation pushed with a
+// CAS before that swap is run by Set; one that finds the mark is run by
+// OnReady itself, so every continuation runs exactly once whatever the
+// interleaving. The first continuation lives in the state itself, so a single
+// Then costs no node allocation. The state is reference counted intrusively
+// by StateRef.
+class SharedStateBase {
+ public:
+  SharedStateBase() = default;
+  SharedStateBase(SharedStateBase const&) = delete;
+  SharedStateBase& operator=(SharedStateBase const&) = delete;
+
+  ~SharedStateBase() {
+    // Only a state that never became ready can have continuations left.
+    auto* continuation{continuations_.load(std::memory_order_acquire)};
+    while (continuation != nullptr && continuation != Ready()) {
+      auto* const next{continuation->next};
+      Release(continuation);
+      continuation = next;
+    }
+  }
+
+  void AddRef() noexcept { refs_.fetch_add(1U, std::memory_order_relaxed); }
+
+  // Returns whether the last reference is gone.
+  bool ReleaseRef() noexcept {
+    return refs_.fetch_sub(1U, std::memory_order_acq_rel) == 1U;
+  }
+
+  bool IsReady() const noexcept {
+    return continuations_.load(std::memory_order_acquire) == Ready();
+  }
+
+  void RequestCancel() noexcept {
+    cancel_requested_.store(true, std::memory_order_relaxed);
+  }
+
+  bool IsCancelRequested() const noexcept {
+    return cancel_requested_.load(std::memory_order_relaxed);
+  }
+
+  bool IsCancelled() const noexcept { return IsReady() && cancelled_; }
+
+  void Wait() const noexcept {
+    if (IsReady()) return;
+
+    auto* const observer{ThisThreadObserver()};
+    if (observer != nullptr) observer->BlockingStarted();
+    for (auto* head{continuations_.load(std::memory_order_acquire)};
+         head != Ready(); head = continuations_.load(std::memory_order_acquire)) {
+      continuations_.wait(head, std::memory_order_acquire);
+    }
+    if (observer != nullptr) observer->BlockingFinished();
+  }
+
+  // Runs callback on the calling thread if the state is ready already,
+  // otherwise on the thread that makes it ready. Any number of callbacks may
+  // be registered, from any threads; they run in the order they were pushed.
+  void OnReady(CALLBACK callback) {
+    auto* head{continuations_.load(std::memory_order_acquire)};
+    if (head == Ready()) {
+      callback();
+      return;
+    }
+
+    auto* const continuation{
+        inline_taken_.exchange(true, std::memory_order_relaxed)
+            ? new Continuation{}
+            : &inline_continuation_};
+    continuation->callback = std::move(callback);
+    do {
+      if (head == Ready()) {
+        auto ready_callback{std::move(continuation->callback)};
+        Release(continuation);
+        ready_callback();
+        return;
+      }
+      continuation->next = head;
+    } while (!continuations_.compare_exchange_weak(
+        head, continuation, std::memory_order_acq_rel,
+        std::memory_order_acquire));
+  }
+
+ protected:
+  // Has to come before the state is made ready.
+  void MarkCancelled() noexcept { cancelled_ = true; }
+
+  void MakeReady() noexcept {
+    auto* head{continuations_.exchange(Ready(), std::memory_order_acq_rel)};
+    continuations_.notify_all();
+
+    Continuation* in_order{nullptr};
+    while (head != nullptr) {
+      auto* const next{head->next};
+      head->next = in_order;
+      in_order = head;
+      head = next;
+    }
+    while (in_order != nullptr) {
+      auto* const next{in_order->next};
+      std::exchange(in_order->callback, {})();
+      Release(in_order);
+      in_order = next;
+    }
+  }
+
+ private:
+  // Stands for a ready state in place of the head of the continuations.
+  static Continuation* Ready() noexcept { return &ready_mark_; }
+
+  void Release(Continuation* continuation) noexcept {
+    if (continuation != &inline_continuation_) delete continuation;
+  }
+
+  static inline Continuation ready_mark_{};
+
+  std::atomic<Continuation*> continuations_{nullptr};
+  std::atomic<unsigned> refs_{1U};
+  std::atomic<bool> cancel_requested_{false};
+  std::atomic<bool> inline_taken_{false};
+  bool cancelled_{false};
+  Continuation inline_continuation_{};
+};
+
+// Routes allocations of State through its BlockCache.
+template <class State>
+class PooledState {
+ public:
+  static void* operator new(std::size_t) {
+    return memory::BlockCache<sizeof(State), alignof(State),
+                              STATE_CACHE_CAPACITY>::Allocate();
+  }
+  static void operator delete(void* block) noexcept {
+    memory::BlockCache<sizeof(State), alignof(State),
+                       STATE_CACHE_CAPACITY>::Deallocate(block);
+  }
+};
+}  // namespace details
+
 template <class T>
-class SharedState {
+class SharedState : public details::SharedStateBase,
+                    public details::PooledState<SharedState<T>> {
  public:
   template <class R>
   void Set(R&& new_val) noexcept {
     val_ = std::forward<R>(new_val);
-    sem_.release();
+    MakeReady();
+  }
+
+  void SetCancelled() noexcept {
+    MarkCancelled();
+    Set(std::make_exception_ptr(TaskCancelled{}));
   }
 
   T Get() {
-    sem_.acquire();
+    Wait();
     if (auto const e{std::get_if<std::exception_ptr>(&val_)}) {
       std::rethrow_exception(*e);
     } else {
@@ -24,42 +244,319 @@ class SharedState {
     }
   }
 
-  bool IsReady() {
-    if (sem_.try_acquire()) {
-      sem_.release();
-      return true;
-    } else {
-      return false;
-    }
-  }
-
  private:
-  std::binary_semaphore sem_{0};
   std::variant<std::monostate, T, std::exception_ptr> val_{};
 };
 
 template <>
-class SharedState<void> {
+class SharedState<void> : public details::SharedStateBase,
+                          public details::PooledState<SharedState<void>> {
  public:
   void Set() noexcept {
-    sem_.release();
+    MakeReady();
   }
   void Set(std::exception_ptr e) noexcept {
     e_ = e;
-    sem_.release();
+    MakeReady();
+  }
+
+  void SetCancelled() noexcept {
+    MarkCancelled();
+    Set(std::make_exception_ptr(TaskCancelled{}));
   }
 
   void Get() {
-    sem_.acquire();
+    Wait();
     if (e_) {
       std::rethrow_exception(e_);
     }
   }
 
  private:
-  std::binary_semaphore sem_{0};
   std::exception_ptr e_{nullptr};
 };
+
+namespace details {
+template <class T>
+class StateRef {
+ public:
+  StateRef() = default;
+
+  StateRef(StateRef const& other) noexcept : state_{other.state_} {
+    if (state_ != nullptr) state_->AddRef();
+  }
+  StateRef(StateRef&& other) noexcept
+      : state_{std::exchange(other.state_, nullptr)} {}
+
+  StateRef& operator=(StateRef other) noexcept {
+    std::swap(state_, other.state_);
+    return *this;
+  }
+
+  ~StateRef() {
+    if (state_ != nullptr && state_->ReleaseRef()) {
+      delete state_;
+    }
+  }
+
+  static StateRef Make() { return StateRef{new SharedState<T>{}}; }
+
+  SharedState<T>* operator->() const noexcept { return state_; }
+
+  explicit operator bool() const noexcept { return state_ != nullptr; }
+
+ private:
+  explicit StateRef(SharedState<T>* state) noexcept : state_{state} {}
+
+  SharedState<T>* state_{nullptr};
+};
+}  // namespace details
+
+template <class T>
+class Future;
+
+template <class T>
+class Promise {
+ public:
+  Promise() = default;
+  Promise(Promise&&) noexcept = default;
+
+  // The state given up is broken first, as on destruction.
+  Promise& operator=(Promise&& other) noexcept {
+    if (this != &other) {
+      Break();
+      state_ = std::move(other.state_);
+    }
+    return *this;
+  }
+
+  ~Promise() { Break(); }
+
+  Future<T> GetFuture() const { return Future<T>{state_}; }
+
+  template <class R>
+    requires(!std::is_void_v<T>)
+  void Set(R&& new_val) noexcept {
+    state_->Set(std::forward<R>(new_val));
+  }
+
+  void Set() noexcept
+    requires std::is_void_v<T>
+  {
+    state_->Set();
+  }
+
+  void SetException(std::exception_ptr e) noexcept { state_->Set(e); }
+
+  // Stores the result of functor(params...), or the exception it throws.
+  template <class F, typename... Args>
+  void SetFrom(F&& functor, Args&&... params) noexcept {
+    try {
+      if constexpr (std::is_void_v<T>) {
+        std::invoke(std::forward<F>(functor), std::forward<Args>(params)...);
+        Set();
+      } else {
+        Set(std::invoke(std::forward<F>(functor), std::forward<Args>(params)...));
+      }
+    } catch (...) {
+      SetException(std::current_exception());
+    }
+  }
+
+  // Like SetFrom, except that functor is not called at all, and the future
+  // is completed as cancelled, if its consumer has called Cancel or
+  // cancellation is due.
+  template <class F, typename... Args>
+  void SetFromUnlessCancelled(Cancellation const& cancellation, F&& functor,
+                              Args&&... params) noexcept {
+    if (state_->IsCancelRequested() || cancellation.IsDue()) {
+      state_->SetCancelled();
+    } else if constexpr (std::invocable<F, std::stop_token, Args...>) {
+      SetFrom(std::forward<F>(functor), cancellation.stop_token,
+              std::forward<Args>(params)...);
+    } else {
+      SetFrom(std::forward<F>(functor), std::forward<Args>(params)...);
+    }
+  }
+
+ private:
+  void Break() noexcept {
+    if (state_ && !state_->IsReady()) {
+      SetException(std::make_exception_ptr(
+          std::future_error{std::future_errc::broken_promise}));
+    }
+  }
+
+  details::StateRef<T> state_{details::StateRef<T>::Make()};
+};
+
+template <class T>
+class Future {
+ public:
+  Future() = default;
+
+  T Get() { return state_->Get(); }
+
+  bool IsReady() const noexcept { return state_->IsReady(); }
+
+  void Wait() const noexcept { state_->Wait(); }
+
+  // Asks for the task to be dropped if it has not started yet; Get then
+  // throws TaskCancelled. A task already running is not interrupted.
+  void Cancel() noexcept { state_->RequestCancel(); }
+
+  // Whether the task was dropped rather than run; false until it is ready.
+  bool IsCancelled() const noexcept { return state_->IsCancelled(); }
+
+  void OnReady(details::CALLBACK callback) {
+    state_->OnReady(std::move(callback));
+  }
+
+  // Schedules continuation(Get()) on scheduler once the value is set, or runs
+  // it right away on the calling thread if it is set already. An exception
+  // stored in this future is passed on to the returned one untouched.
+  template <Scheduler S, class F>
+  auto Then(S& scheduler, F&& continuation) {
+    using continuation_return_t = typename std::conditional_t<
+        std::is_void_v<T>, std::invoke_result<F>,
+        std::invoke_result<F, T>>::type;
+    Promise<continuation_return_t> promise{};
+    auto future{promise.GetFuture()};
+    if (IsReady()) {
+      Continue(state_, std::forward<F>(continuation), std::move(promise));
+    } else {
+      state_->OnReady([&scheduler, state = state_,
+                       continuation = std::forward<F>(continuation),
+                       promise = std::move(promise)] mutable {
+        scheduler.Post([state = std::move(state),
+                        continuation = std::move(continuation),
+                        promise = std::move(promise)] mutable {
+          Continue(state, std::move(continuation), std::move(promise));
+        });
+      });
+    }
+    return future;
+  }
+
+ private:
+  friend class Promise<T>;
+
+  explicit Future(details::StateRef<T> state)
+      : state_{std::move(state)} {}
+
+  template <class F, class U>
+  static void Continue(details::StateRef<T> const& state,
+                       F&& continuation, Promise<U> promise) noexcept {
+    if constexpr (std::is_void_v<T>) {
+      promise.SetFrom([&state, &continuation] {
+        state->Get();
+        return std::invoke(std::forward<F>(continuation));
+      });
+    } else {
+      promise.SetFrom([&state, &continuation] {
+        return std::invoke(std::forward<F>(continuation), state->Get());
+      });
+    }
+  }
+
+ private:
+  details::StateRef<T> state_{};
+};
+
+// Result type of a task that may take the std::stop_token of its Cancellation.
+template <class F, typename... Args>
+using TASK_RESULT = typename std::conditional_t<
+    std::invocable<F, std::stop_token, Args...>,
+    std::invoke_result<F, std::stop_token, Args...>,
+    std::invoke_result<F, Args...>>::type;
+
+// Runs functor(params...) on scheduler, unless cancellation is due by the
+// time it is picked up, and returns the future of its result.
+template <Scheduler S, class F, typename... Args>
+auto Async(S& scheduler, Cancellation cancellation, F&& functor,
+           Args&&... params) {
+  Promise<TASK_RESULT<F, Args...>> promise{};
+  auto future{promise.GetFuture()};
+  scheduler.Post([promise = std::move(promise),
+                  cancellation = std::move(cancellation),
+                  functor = std::forward<F>(functor),
+                  ... params = std::forward<Args>(params)] mutable {
+    promise.SetFromUnlessCancelled(cancellation, std::move(functor),
+                                   std::move(params)...);
+  });
+  return future;
+}
+
+template <Scheduler S, class F, typename... Args>
+  requires(!std::same_as<std::remove_cvref_t<F>, Cancellation>)
+auto Async(S& scheduler, F&& functor, Args&&... params) {
+  return Async(scheduler, Cancellation{}, std::forward<F>(functor),
+               std::forward<Args>(params)...);
+}
+
+// Becomes ready once every one of futures is, after a single countdown and a
+// single wake-up rather than a wait per future; their results are then read
+// with Get without blocking. The futures keep whatever continuations they
+// have.
+template <std::ranges::sized_range R>
+Future<void> WhenAll(R&& futures) {
+  struct Context {
+    explicit Context(std::size_t count) : remaining{count} {}
+
+    void CountDown(std::size_t count) noexcept {
+      if (remaining.fetch_sub(count) == count) promise.Set();
+    }
+
+    std::atomic<std::size_t> remaining;
+    Promise<void> promise{};
+  };
+
+  // One extra count keeps the promise unset until every callback is in.
+  auto context{std::make_shared<Context>(std::ranges::size(futures) + 1ULL)};
+  auto all_ready{context->promise.GetFuture()};
+  std::size_t ready_count{1ULL};
+  for (auto& future : futures) {
+    if (future.IsReady()) {
+      ++ready_count;
+    } else {
+      future.OnReady([context] { context->CountDown(1ULL); });
+    }
+  }
+  context->CountDown(ready_count);
+  return all_ready;
+}
+
+// Becomes ready with the index of the first of futures found ready, or with
+// the size of the range if it is empty. Every call leaves a continuation on
+// each future not found ready, which stays until that future is set, so
+// calling it again and again to drain a range in the order it finishes
+// costs quadratically; push to a CompletionQueue from OnReady instead.
+template <std::ranges::sized_range R>
+Future<std::size_t> WhenAny(R&& futures) {
+  struct Context {
+    void Settle(std::size_t index) noexcept {
+      if (!settled.exchange(true)) promise.Set(index);
+    }
+
+    std::atomic<bool> settled{false};
+    Promise<std::size_t> promise{};
+  };
+
+  auto context{std::make_shared<Context>()};
+  auto any_ready{context->promise.GetFuture()};
+  std::size_t index{0ULL};
+  for (auto& future : futures) {
+    if (context->settled.load()) break;
+    if (future.IsReady()) {
+      context->Settle(index);
+      break;
+    }
+    future.OnReady([context, index] { context->Settle(index); });
+    ++index;
+  }
+  if (std::ranges::empty(futures)) context->Settle(0ULL);
+  return any_ready;
+}
 }  // namespace multithreading::futurama
 
-#endif  // !SHARED_STATE_HPP
\ No newline at end of file
+#endif  // !SHARED_STATE_HPP
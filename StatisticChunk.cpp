@@ -11,14 +11,16 @@ void StatisticChunk::save_as_csv(std::span<StatisticChunk const> stats,
   static std::filesystem::path const CSV_EXTENSION_NAME{"csv"};
   uri.replace_extension(CSV_EXTENSION_NAME);
   std::ofstream csv{uri};
-  for (std::size_t i{0ULL}; i < config::SLAVES_COUNT; ++i) {
+  auto const slaves_count{
+      stats.empty() ? 0ULL : stats.front().timing_per_thread.size()};
+  for (std::size_t i{0ULL}; i < slaves_count; ++i) {
     csv << std::format("work_{0:};idle_{0:};heavies_{0:};", i);
   }
   csv << "total_time;total_heavies;total_idle" << std::endl;
 
   for (auto const& chunk : stats) {
     long long total_idle{0LL};
-    for (std::size_t i{0ULL}; i < config::SLAVES_COUNT; ++i) {
+    for (std::size_t i{0ULL}; i < chunk.timing_per_thread.size(); ++i) {
       auto const cur_idle{chunk.total_timing - chunk.timing_per_thread[i]};
       csv << std::format("{};{};{};", chunk.timing_per_thread[i], cur_idle,
                          chunk.number_of_heavy_jobs_per_thread[i]);
@@ -1,14 +1,19 @@
 #ifndef STATISTIC_CHUNK_HPP
 #define STATISTIC_CHUNK_HPP
 
-#include <array>
 #include <filesystem>
+#include <span>
+#include <vector>
 
 #include "config.hpp"
 
 struct StatisticChunk {
-  std::array<long long, config::SLAVES_COUNT> timing_per_thread{};
-  std::array<std::size_t, config::SLAVES_COUNT> number_of_heavy_jobs_per_thread{};
+  explicit StatisticChunk(std::size_t slaves_count)
+      : timing_per_thread(slaves_count),
+        number_of_heavy_jobs_per_thread(slaves_count) {}
+
+  std::vector<long long> timing_per_thread{};
+  std::vector<std::size_t> number_of_heavy_jobs_per_thread{};
   long long total_timing{};
 
   static void save_as_csv(std::span<StatisticChunk const> stats, std::filesystem::path uri);
@@ -0,0 +1,131 @@
+#ifndef STEALING_DEQUE_HPP
+#define STEALING_DEQUE_HPP
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <gsl/gsl>
+
+namespace multithreading::lockfree {
+// Chase-Lev work-stealing deque in the formulation of Le et al., "Correct and
+// Efficient Work-Stealing for Weak Memory Models" (PPoPP'13).
+// Push/Pop may only be called by the owning thread and work at the bottom;
+// Steal may be called by any thread and takes from the top. The deque stores
+// raw pointers and never owns the pointees.
+template <class T>
+class StealingDeque {
+ private:
+  class Buffer {
+   public:
+    explicit Buffer(gsl::index capacity)
+        : mask_{capacity - 1},
+          slots_{std::make_unique<std::atomic<T*>[]>(
+              gsl::narrow_cast<std::size_t>(capacity))} {}
+
+    gsl::index Capacity() const noexcept { return mask_ + 1; }
+
+    T* Get(gsl::index i) const noexcept {
+      return slots_[gsl::narrow_cast<std::size_t>(i & mask_)].load(
+          std::memory_order_relaxed);
+    }
+
+    void Put(gsl::index i, T* item) noexcept {
+      slots_[gsl::narrow_cast<std::size_t>(i & mask_)].store(
+          item, std::memory_order_relaxed);
+    }
+
+   private:
+    gsl::index mask_;
+    std::unique_ptr<std::atomic<T*>[]> slots_;
+  };
+
+ public:
+  explicit StealingDeque(std::size_t initial_capacity = 256ULL) {
+    auto buffer{std::make_unique<Buffer>(
+        gsl::narrow_cast<gsl::index>(std::bit_ceil(initial_capacity)))};
+    buffer_.store(buffer.get(), std::memory_order_relaxed);
+    buffers_.push_back(std::move(buffer));
+  }
+
+  StealingDeque(StealingDeque const&) = delete;
+  StealingDeque& operator=(StealingDeque const&) = delete;
+
+  void Push(T* item) {
+    auto const b{bottom_.load(std::memory_order_relaxed)};
+    auto const t{top_.load(std::memory_order_acquire)};
+    auto* buffer{buffer_.load(std::memory_order_relaxed)};
+    if (b - t > buffer->Capacity() - 1) {
+      buffer = Grow(buffer, t, b);
+    }
+    buffer->Put(b, item);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+  }
+
+  T* Pop() noexcept {
+    auto const b{bottom_.load(std::memory_order_relaxed) - 1};
+    auto* const buffer{buffer_.load(std::memory_order_relaxed)};
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto t{top_.load(std::memory_order_relaxed)};
+
+    if (t > b) {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    auto* item{buffer->Get(b)};
+    if (t == b) {
+      // Last element: race against thieves for it.
+      if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+        item = nullptr;
+      }
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return item;
+  }
+
+  T* Steal() noexcept {
+    auto t{top_.load(std::memory_order_acquire)};
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto const b{bottom_.load(std::memory_order_acquire)};
+    if (t >= b) return nullptr;
+
+    auto* const item{buffer_.load(std::memory_order_acquire)->Get(t)};
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return item;
+  }
+
+  bool Empty() const noexcept {
+    return bottom_.load(std::memory_order_relaxed) <=
+           top_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  Buffer* Grow(Buffer* old_buffer, gsl::index t, gsl::index b) {
+    auto buffer{std::make_unique<Buffer>(old_buffer->Capacity() * 2)};
+    for (auto i{t}; i < b; ++i) {
+      buffer->Put(i, old_buffer->Get(i));
+    }
+    // Thieves may still read from the old buffer, so it is kept alive until
+    // the deque itself is destroyed.
+    buffer_.store(buffer.get(), std::memory_order_release);
+    buffers_.push_back(std::move(buffer));
+    return buffers_.back().get();
+  }
+
+ private:
+  alignas(64) std::atomic<gsl::index> top_{0};
+  alignas(64) std::atomic<gsl::index> bottom_{0};
+  alignas(64) std::atomic<Buffer*> buffer_{nullptr};
+  std::vector<std::unique_ptr<Buffer>> buffers_{};
+};
+}  // namespace multithreading::lockfree
+
+#endif  // !STEALING_DEQUE_HPP
@@ -20,6 +20,8 @@ class Task {
   }
 
   virtual DUMMY_OUTPUT do_stuff() const = 0;
+  // Relative cost of do_stuff() in elementary math calls, used for ordering.
+  virtual std::size_t get_estimated_cost() const noexcept = 0;
 
  protected:
   DUMMY_INPUT val{generate_val()};
@@ -0,0 +1,136 @@
+#ifndef TASK_GRAPH_HPP
+#define TASK_GRAPH_HPP
+
+#include "SharedState.hpp"
+#include "TaskGroup.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <gsl/gsl>
+
+namespace multithreading::pool {
+// Dependency graph of tasks, built once and run any number of times on a
+// futurama::Scheduler. Every run starts with the nodes that have no
+// predecessors; a node becomes ready once the last of its predecessors has
+// finished, which is found out with an atomic countdown per node instead of
+// blocking on a future. The thread finishing a node goes on with one of the
+// successors it made ready and spawns the others, so a chain of nodes runs
+// without a round trip through the scheduler. Runs go through a TaskGroup,
+// so Run helps with the graph's own nodes while it waits, and the first
+// exception thrown by a node skips whatever has not started yet and is
+// rethrown by Run.
+// A graph must not be modified or run again while it is running.
+class TaskGraph {
+ public:
+  using NODE_ID = std::size_t;
+
+  template <class F>
+    requires std::invocable<std::decay_t<F>&>
+  NODE_ID Emplace(F&& functor) {
+    nodes_.push_back(Node{.work = std::forward<F>(functor)});
+    is_validated_ = false;
+    return nodes_.size() - 1ULL;
+  }
+
+  // after may only start once before has finished.
+  void Precede(NODE_ID before, NODE_ID after) {
+    assert(before < nodes_.size() && after < nodes_.size());
+    nodes_[before].successors.push_back(after);
+    ++nodes_[after].predecessors_count;
+    is_validated_ = false;
+  }
+
+  std::size_t Size() const noexcept { return nodes_.size(); }
+
+  // Returns once every node has run; throws std::invalid_argument if the
+  // graph has a cycle. Nodes not started yet are skipped once cancellation is
+  // due.
+  template <futurama::Scheduler S>
+  void Run(S& scheduler, futurama::Cancellation cancellation = {}) {
+    if (!is_validated_) Validate();
+
+    for (auto const& [id, node] : std::views::enumerate(nodes_)) {
+      pending_[id].store(node.predecessors_count, std::memory_order_relaxed);
+    }
+    TaskGroup group{scheduler, std::move(cancellation)};
+    for (auto const root : roots_) {
+      group.Spawn([this, &group, root] { RunFrom(group, root); });
+    }
+    group.Wait();
+  }
+
+ private:
+  struct Node {
+    std::move_only_function<void()> work{};
+    std::vector<NODE_ID> successors{};
+    std::size_t predecessors_count{0ULL};
+  };
+
+  template <class Group>
+  void RunFrom(Group& group, NODE_ID id) {
+    while (true) {
+      auto& node{nodes_[id]};
+      node.work();
+
+      std::optional<NODE_ID> next{};
+      for (auto const successor : node.successors) {
+        if (pending_[successor].fetch_sub(1ULL) != 1ULL) continue;
+        if (!next) {
+          next = successor;
+        } else {
+          group.Spawn([this, &group, successor] { RunFrom(group, successor); });
+        }
+      }
+      if (!next || group.IsCancelled()) return;
+      id = *next;
+    }
+  }
+
+  // Kahn's algorithm; also sizes the countdowns and collects the roots.
+  void Validate() {
+    std::vector<std::size_t> pending{};
+    pending.reserve(nodes_.size());
+    roots_.clear();
+    for (auto const& [id, node] : std::views::enumerate(nodes_)) {
+      pending.push_back(node.predecessors_count);
+      if (node.predecessors_count == 0ULL) {
+        roots_.push_back(gsl::narrow_cast<NODE_ID>(id));
+      }
+    }
+
+    auto ready{roots_};
+    std::size_t visited_count{0ULL};
+    while (!ready.empty()) {
+      auto const id{ready.back()};
+      ready.pop_back();
+      ++visited_count;
+      for (auto const successor : nodes_[id].successors) {
+        if (--pending[successor] == 0ULL) ready.push_back(successor);
+      }
+    }
+    if (visited_count != nodes_.size()) {
+      throw std::invalid_argument{"TaskGraph has a cycle"};
+    }
+
+    pending_ = std::vector<std::atomic<std::size_t>>(nodes_.size());
+    is_validated_ = true;
+  }
+
+  std::vector<Node> nodes_{};
+  std::vector<NODE_ID> roots_{};
+  // Predecessors of every node that have not finished yet in the current run.
+  std::vector<std::atomic<std::size_t>> pending_{};
+  bool is_validated_{false};
+};
+}  // namespace multithreading::pool
+
+#endif  // !TASK_GRAPH_HPP
@@ -0,0 +1,124 @@
+#ifndef TASK_GROUP_HPP
+#define TASK_GROUP_HPP
+
+#include "InlineTask.hpp"
+#include "LockedQueue.hpp"
+#include "SharedState.hpp"
+
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace multithreading::pool {
+// Fork-join scope on top of a futurama::Scheduler. Spawned tasks are kept in
+// the group's own queue and the scheduler only gets a token per task that
+// runs the next one of them, so Wait can run the group's pending tasks on the
+// calling thread instead of blocking, and never picks up unrelated work.
+// Nested groups in recursive jobs therefore make progress with any number of
+// slaves. Wait blocks only while tasks of the group run elsewhere, and lets
+// the thread's futurama::BlockingObserver know about it.
+// The first exception thrown by a task cancels the group and is rethrown by
+// Wait; cancelled tasks that have not started yet are skipped. Tasks are
+// skipped as well once the cancellation the group was made with is due. After
+// Wait the group may be reused.
+template <futurama::Scheduler S>
+class TaskGroup {
+ public:
+  explicit TaskGroup(S& scheduler, futurama::Cancellation cancellation = {})
+      : scheduler_{scheduler},
+        state_{std::make_shared<State>(std::move(cancellation))} {}
+
+  TaskGroup(TaskGroup const&) = delete;
+  TaskGroup& operator=(TaskGroup const&) = delete;
+
+  // A group left without Wait still lets its tasks finish; an error they
+  // raised is dropped.
+  ~TaskGroup() { state_->Help(); }
+
+  template <class F>
+    requires std::invocable<std::decay_t<F>&>
+  void Spawn(F&& functor) {
+    InlineTask task{std::forward<F>(functor)};
+    state_->pending_count.fetch_add(1ULL);
+    state_->tasks.TryPushBulk(std::span{&task, 1ULL});
+    scheduler_.Post([state = state_] { state->RunNext(); });
+  }
+
+  void Wait() {
+    state_->Help();
+    state_->cancelled.store(false);
+    if (auto error{std::exchange(state_->error, nullptr)}) {
+      std::rethrow_exception(std::move(error));
+    }
+  }
+
+  void Cancel() noexcept { state_->cancelled.store(true); }
+
+  bool IsCancelled() const noexcept { return state_->IsCancelled(); }
+
+ private:
+  // Outlives the group while tokens of it are still queued in the scheduler.
+  struct State {
+    explicit State(futurama::Cancellation cancellation_init)
+        : cancellation{std::move(cancellation_init)} {}
+
+    bool IsCancelled() const noexcept {
+      return cancelled.load() || cancellation.IsDue();
+    }
+
+    void RunNext() {
+      if (auto task{tasks.TryPop()}) {
+        Run(*task);
+      }
+    }
+
+    void Run(InlineTask& task) noexcept {
+      if (!IsCancelled()) {
+        try {
+          task();
+        } catch (...) {
+          std::lock_guard lk{error_mtx};
+          if (!error) error = std::current_exception();
+          cancelled.store(true);
+        }
+      }
+      if (pending_count.fetch_sub(1ULL) == 1ULL) {
+        pending_count.notify_all();
+      }
+    }
+
+    void Help() noexcept {
+      while (true) {
+        auto const pending{pending_count.load()};
+        if (pending == 0ULL) return;
+        if (auto task{tasks.TryPop()}) {
+          Run(*task);
+          continue;
+        }
+        auto* const observer{futurama::ThisThreadObserver()};
+        if (observer != nullptr) observer->BlockingStarted();
+        pending_count.wait(pending);
+        if (observer != nullptr) observer->BlockingFinished();
+      }
+    }
+
+    LockedQueue<InlineTask> tasks{};
+    std::atomic<std::size_t> pending_count{0ULL};
+    futurama::Cancellation const cancellation;
+    std::atomic<bool> cancelled{false};
+    std::mutex error_mtx{};
+    std::exception_ptr error{nullptr};
+  };
+
+  S& scheduler_;
+  std::shared_ptr<State> state_;
+};
+}  // namespace multithreading::pool
+
+#endif  // !TASK_GROUP_HPP
@@ -0,0 +1,208 @@
+#include "affinity.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <string>
+#include <tuple>
+
+#ifdef __linux__
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <sstream>
+
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace affinity {
+namespace {
+struct LogicalCpu {
+  unsigned id{};
+  unsigned package{};
+  unsigned core{};
+  unsigned node{};
+  // Position among the SMT siblings of its physical core.
+  unsigned sibling_index{};
+  // Position of its physical core within its node.
+  unsigned core_index{};
+};
+
+#ifdef __linux__
+// "0-3,8,10-11" -> {0, 1, 2, 3, 8, 10, 11}
+CPU_LIST parse_cpu_list(std::string const& list) {
+  CPU_LIST cpus{};
+  std::istringstream stream{list};
+  for (std::string range{}; std::getline(stream, range, ',');) {
+    if (range.empty()) continue;
+    auto const dash{range.find('-')};
+    auto const first{std::stoul(range.substr(0ULL, dash))};
+    auto const last{dash == std::string::npos
+                        ? first
+                        : std::stoul(range.substr(dash + 1ULL))};
+    for (auto cpu{first}; cpu <= last; ++cpu) {
+      cpus.push_back(static_cast<unsigned>(cpu));
+    }
+  }
+  return cpus;
+}
+
+std::optional<std::string> read_line(std::filesystem::path const& path) {
+  std::ifstream file{path};
+  std::string line{};
+  if (!std::getline(file, line)) return std::nullopt;
+  return line;
+}
+
+unsigned read_number(std::filesystem::path const& path, unsigned fallback) {
+  auto const line{read_line(path)};
+  if (!line) return fallback;
+  try {
+    return static_cast<unsigned>(std::stoul(*line));
+  } catch (std::exception const&) {
+    return fallback;
+  }
+}
+
+std::map<unsigned, unsigned> read_nodes() {
+  static std::filesystem::path const NODE_ROOT{"/sys/devices/system/node"};
+  static std::string const NODE_PREFIX{"node"};
+
+  std::map<unsigned, unsigned> node_of_cpu{};
+  std::error_code error{};
+  for (auto const& entry :
+       std::filesystem::directory_iterator{NODE_ROOT, error}) {
+    auto const name{entry.path().filename().string()};
+    if (!name.starts_with(NODE_PREFIX) || name.size() == NODE_PREFIX.size() ||
+        !std::ranges::all_of(name.substr(NODE_PREFIX.size()),
+                             [](unsigned char c) { return std::isdigit(c); })) {
+      continue;
+    }
+    auto const node{
+        static_cast<unsigned>(std::stoul(name.substr(NODE_PREFIX.size())))};
+    if (auto const cpu_list{read_line(entry.path() / "cpulist")}) {
+      for (auto const cpu : parse_cpu_list(*cpu_list)) {
+        node_of_cpu[cpu] = node;
+      }
+    }
+  }
+  return node_of_cpu;
+}
+
+// Online CPUs the process may run on, sorted by node, package, core and id.
+std::vector<LogicalCpu> read_topology() {
+  static std::filesystem::path const CPU_ROOT{"/sys/devices/system/cpu"};
+
+  auto const online{read_line(CPU_ROOT / "online")};
+  if (!online) return {};
+  cpu_set_t allowed{};
+  CPU_ZERO(&allowed);
+  auto const is_restricted{sched_getaffinity(0, sizeof(allowed), &allowed) ==
+                           0};
+  auto const node_of_cpu{read_nodes()};
+
+  std::vector<LogicalCpu> cpus{};
+  for (auto const id : parse_cpu_list(*online)) {
+    if (is_restricted && id < CPU_SETSIZE && !CPU_ISSET(id, &allowed)) {
+      continue;
+    }
+    auto const topology{CPU_ROOT / ("cpu" + std::to_string(id)) / "topology"};
+    auto const node{node_of_cpu.find(id)};
+    cpus.push_back({.id = id,
+                    .package = read_number(topology / "physical_package_id", 0U),
+                    .core = read_number(topology / "core_id", id),
+                    .node = node == node_of_cpu.end() ? 0U : node->second});
+  }
+
+  std::ranges::sort(cpus, {}, [](LogicalCpu const& cpu) {
+    return std::tuple{cpu.node, cpu.package, cpu.core, cpu.id};
+  });
+  std::map<unsigned, unsigned> cores_count_of_node{};
+  for (std::size_t i{0ULL}; i < cpus.size(); ++i) {
+    auto& cpu{cpus[i]};
+    if (i > 0ULL && cpus[i - 1ULL].node == cpu.node &&
+        cpus[i - 1ULL].package == cpu.package &&
+        cpus[i - 1ULL].core == cpu.core) {
+      cpu.sibling_index = cpus[i - 1ULL].sibling_index + 1U;
+      cpu.core_index = cpus[i - 1ULL].core_index;
+    } else {
+      cpu.core_index = cores_count_of_node[cpu.node]++;
+    }
+  }
+  return cpus;
+}
+#else
+std::vector<LogicalCpu> read_topology() { return {}; }
+#endif
+
+// A topology that cannot be read or parsed leaves every worker unpinned, as
+// Placement::NONE does, rather than failing the pool being set up.
+std::vector<LogicalCpu> const& topology() {
+  static auto const cpus{[]() -> std::vector<LogicalCpu> {
+    try {
+      return read_topology();
+    } catch (std::exception const&) {
+      return {};
+    }
+  }()};
+  return cpus;
+}
+}  // namespace
+
+std::vector<CPU_LIST> plan(Placement placement, std::size_t workers_count) {
+  std::vector<CPU_LIST> sets(workers_count);
+  auto cpus{topology()};
+  if (placement == Placement::NONE || cpus.empty()) return sets;
+
+  switch (placement) {
+    case Placement::NONE:
+    case Placement::COMPACT:
+      break;
+    case Placement::SCATTER:
+      std::ranges::stable_sort(cpus, {}, [](LogicalCpu const& cpu) {
+        return std::tuple{cpu.sibling_index, cpu.core_index, cpu.node};
+      });
+      break;
+    case Placement::PHYSICAL_CORES:
+      std::erase_if(cpus,
+                    [](LogicalCpu const& cpu) { return cpu.sibling_index > 0U; });
+      break;
+    case Placement::NUMA_NODES: {
+      std::vector<CPU_LIST> nodes{};
+      for (std::size_t i{0ULL}; i < cpus.size(); ++i) {
+        if (i == 0ULL || cpus[i].node != cpus[i - 1ULL].node) {
+          nodes.emplace_back();
+        }
+        nodes.back().push_back(cpus[i].id);
+      }
+      for (std::size_t i{0ULL}; i < workers_count; ++i) {
+        sets[i] = nodes[i % nodes.size()];
+      }
+      return sets;
+    }
+  }
+  for (std::size_t i{0ULL}; i < workers_count; ++i) {
+    sets[i] = {cpus[i % cpus.size()].id};
+  }
+  return sets;
+}
+
+void pin_current_thread(CPU_LIST const& cpus) {
+#ifdef __linux__
+  if (cpus.empty()) return;
+
+  cpu_set_t set{};
+  CPU_ZERO(&set);
+  for (auto const cpu : cpus) {
+    if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+  }
+  // Placement is best effort: a CPU that went offline just leaves the thread
+  // where it is.
+  std::ignore = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+  std::ignore = cpus;
+#endif
+}
+}  // namespace affinity
@@ -0,0 +1,32 @@
+#ifndef AFFINITY_HPP
+#define AFFINITY_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace affinity {
+// Where workers of one pool are pinned:
+// NONE           - nowhere, the scheduler is free to migrate them;
+// COMPACT        - worker i to logical CPU i, SMT siblings next to each other;
+// SCATTER        - one logical CPU per physical core first, spread round-robin
+//                  across NUMA nodes, SMT siblings only after every core has
+//                  been used once;
+// PHYSICAL_CORES - at most one worker per physical core;
+// NUMA_NODES     - worker i to all CPUs of node i % nodes, free to move within
+//                  the node.
+// Workers beyond the available CPUs wrap around.
+enum class Placement { NONE, COMPACT, SCATTER, PHYSICAL_CORES, NUMA_NODES };
+
+using CPU_LIST = std::vector<unsigned>;
+
+// Logical CPUs for each of workers_count workers; an empty set means the
+// worker is left unpinned. The topology is read from /sys/devices/system/cpu
+// once and limited to the CPUs the process may run on. On other platforms,
+// or if the topology cannot be read, every set is empty.
+std::vector<CPU_LIST> plan(Placement placement, std::size_t workers_count);
+
+// Restricts the calling thread to cpus; no-op for an empty set.
+void pin_current_thread(CPU_LIST const& cpus);
+}  // namespace affinity
+
+#endif  // !AFFINITY_HPP
@@ -0,0 +1,82 @@
+#include "allocation_count.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+namespace allocation_count {
+namespace {
+std::atomic<bool> is_enabled{false};
+std::atomic<std::size_t> count{0ULL};
+
+#ifdef MULTITHREADING_COUNT_ALLOCATIONS
+void* allocate(std::size_t size, std::size_t alignment) {
+  if (is_enabled.load(std::memory_order_relaxed)) {
+    count.fetch_add(1ULL, std::memory_order_relaxed);
+  }
+  size = std::max(size, std::size_t{1});
+  void* block{nullptr};
+  if (alignment <= alignof(std::max_align_t)) {
+    block = std::malloc(size);
+  } else {
+#ifdef _MSC_VER
+    block = _aligned_malloc(size, alignment);
+#else
+    block = std::aligned_alloc(alignment,
+                               (size + alignment - 1ULL) / alignment * alignment);
+#endif
+  }
+  if (block == nullptr) throw std::bad_alloc{};
+  return block;
+}
+
+void deallocate(void* block, std::size_t alignment) noexcept {
+  if (alignment <= alignof(std::max_align_t)) {
+    std::free(block);
+  } else {
+#ifdef _MSC_VER
+    _aligned_free(block);
+#else
+    std::free(block);
+#endif
+  }
+}
+#endif  // MULTITHREADING_COUNT_ALLOCATIONS
+}  // namespace
+
+void enable() noexcept { is_enabled.store(true); }
+
+std::size_t get() noexcept { return count.load(); }
+}  // namespace allocation_count
+
+#ifdef MULTITHREADING_COUNT_ALLOCATIONS
+void* operator new(std::size_t size) {
+  return allocation_count::allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  return allocation_count::allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* block) noexcept {
+  allocation_count::deallocate(block, alignof(std::max_align_t));
+}
+
+void operator delete(void* block, std::size_t) noexcept {
+  allocation_count::deallocate(block, alignof(std::max_align_t));
+}
+
+void operator delete(void* block, std::align_val_t alignment) noexcept {
+  allocation_count::deallocate(block, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* block, std::size_t,
+                     std::align_val_t alignment) noexcept {
+  allocation_count::deallocate(block, static_cast<std::size_t>(alignment));
+}
+#endif  // MULTITHREADING_COUNT_ALLOCATIONS
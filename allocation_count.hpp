@@ -0,0 +1,24 @@
+#ifndef ALLOCATION_COUNT_HPP
+#define ALLOCATION_COUNT_HPP
+
+#include <cstddef>
+
+namespace allocation_count {
+// Only a build with MULTITHREADING_COUNT_ALLOCATIONS defined replaces the
+// global operator new by one that counts its calls, on all threads, once
+// counting has been switched on; until then it only costs a relaxed load.
+// Array and nothrow forms go through it as well. Other builds, the
+// benchmarks among them, keep the standard one and count nothing.
+#ifdef MULTITHREADING_COUNT_ALLOCATIONS
+inline constexpr bool IS_AVAILABLE{true};
+#else
+inline constexpr bool IS_AVAILABLE{false};
+#endif
+
+void enable() noexcept;
+
+// Calls to operator new since counting was switched on.
+std::size_t get() noexcept;
+}  // namespace allocation_count
+
+#endif  // !ALLOCATION_COUNT_HPP
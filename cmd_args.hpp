@@ -11,29 +11,93 @@ static constexpr auto GENERATE_EVENED_DATASET{"--evened"sv};
 
 static constexpr auto USE_SINGLETHREADING{"--singlethreading"sv};
 static constexpr auto USE_MULTITHREADING{"--multithreading"sv};
+static constexpr auto USE_MULTITHREADING_BARRIER{"--multithreading-barrier"sv};
 static constexpr auto USE_MULTITHREADING_QUEUE{"--multithreading-queue"sv};
+static constexpr auto QUEUE_DISPENSING{"--queue-dispensing"sv};
+static constexpr auto QUEUE_LOOKAHEAD{"--queue-lookahead"sv};
+static constexpr auto LARGEST_FIRST{"--largest-first"sv};
+static constexpr auto PLACEMENT{"--placement"sv};
+static constexpr auto SLAVES_COUNT{"--slaves-count"sv};
 static constexpr auto USE_MULTITHREADING_POOL{"--multithreading-pool"sv};
+static constexpr auto POOL_CAPACITY{"--pool-capacity"sv};
+static constexpr auto POOL_OVERFLOW{"--pool-overflow"sv};
+static constexpr auto POOL_BACKEND{"--pool-backend"sv};
+static constexpr auto USE_MULTITHREADING_POOL_REDUCE{"--multithreading-pool-reduce"sv};
 
 static constexpr auto USE_MULTITHREADING_DYNAMIC{"--multithreading-dynamic"sv};
+static constexpr auto USE_MULTITHREADING_COMPLETIONS{
+    "--multithreading-completions"sv};
 static constexpr auto ASYNC_THREADS_COUNT{"--async-threads-count"sv};
 static constexpr auto COMPUTE_THREADS_COUNT{"--compute-threads-count"sv};
 static constexpr auto DATASET_SIZE{"--dataset-size"sv};
 static constexpr auto HEAVY_TASKS_COUNT{"--heavy-tasks-count"sv};
 
 static constexpr auto USE_MULTITHREADING_STEALING{"--multithreading-stealing"sv};
+static constexpr auto USE_MULTITHREADING_CONTINUATIONS{
+    "--multithreading-continuations"sv};
+static constexpr auto USE_MULTITHREADING_COROUTINES{
+    "--multithreading-coroutines"sv};
+static constexpr auto USE_MULTITHREADING_GRAPH{"--multithreading-graph"sv};
+static constexpr auto USE_MULTITHREADING_TASK_GROUPS{
+    "--multithreading-task-groups"sv};
+static constexpr auto TIME_BUDGET_MS{"--time-budget-ms"sv};
+static constexpr auto COUNT_ALLOCATIONS{"--count-allocations"sv};
 
 static constexpr std::array OPTIONS{GENERATE_STACKED_DATASET,
                                     GENERATE_EVENED_DATASET,
                                     USE_SINGLETHREADING,
                                     USE_MULTITHREADING,
+                                    USE_MULTITHREADING_BARRIER,
                                     USE_MULTITHREADING_QUEUE,
+                                    QUEUE_DISPENSING,
+                                    QUEUE_LOOKAHEAD,
+                                    LARGEST_FIRST,
+                                    PLACEMENT,
+                                    SLAVES_COUNT,
                                     USE_MULTITHREADING_POOL,
+                                    POOL_CAPACITY,
+                                    POOL_OVERFLOW,
+                                    POOL_BACKEND,
+                                    USE_MULTITHREADING_POOL_REDUCE,
                                     USE_MULTITHREADING_DYNAMIC,
+                                    USE_MULTITHREADING_COMPLETIONS,
                                     ASYNC_THREADS_COUNT,
                                     COMPUTE_THREADS_COUNT,
                                     DATASET_SIZE,
                                     HEAVY_TASKS_COUNT,          
-                                    USE_MULTITHREADING_STEALING};
+                                    USE_MULTITHREADING_STEALING,
+                                    USE_MULTITHREADING_CONTINUATIONS,
+                                    USE_MULTITHREADING_COROUTINES,
+                                    USE_MULTITHREADING_GRAPH,
+                                    USE_MULTITHREADING_TASK_GROUPS,
+                                    TIME_BUDGET_MS,
+                                    COUNT_ALLOCATIONS};
+
+namespace queue_dispensing {
+static constexpr auto SINGLE{"single"sv};
+static constexpr auto FIXED_CHUNK{"chunk"sv};
+static constexpr auto GUIDED{"guided"sv};
+static constexpr auto FACTORING{"factoring"sv};
+static constexpr auto TRAPEZOID{"trapezoid"sv};
+}  // namespace queue_dispensing
+
+namespace pool_overflow {
+static constexpr auto BLOCK{"block"sv};
+static constexpr auto CALLER_RUNS{"caller-runs"sv};
+}  // namespace pool_overflow
+
+namespace pool_backend {
+static constexpr auto LOCKED{"locked"sv};
+static constexpr auto RING{"ring"sv};
+}  // namespace pool_backend
+
+namespace placement {
+static constexpr auto NONE{"none"sv};
+static constexpr auto COMPACT{"compact"sv};
+static constexpr auto SCATTER{"scatter"sv};
+static constexpr auto PHYSICAL_CORES{"physical"sv};
+static constexpr auto NUMA_NODES{"numa"sv};
+}  // namespace placement
 }  // namespace cmd_args
 
 #endif  // !CMD_ARGS
\ No newline at end of file
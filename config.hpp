@@ -9,9 +9,9 @@
 namespace config {
 constexpr std::size_t CHUNKS_COUNT{100ULL};
 constexpr std::size_t CHUNK_SIZE{10'000ULL};
-constexpr std::size_t SLAVES_COUNT{4ULL};
-static_assert(CHUNK_SIZE >= SLAVES_COUNT);
-static_assert(CHUNK_SIZE % SLAVES_COUNT == 0ULL);
+// Slaves of the static, queue and barrier experiments, unless set otherwise
+// at run time.
+constexpr std::size_t DEFAULT_SLAVES_COUNT{4ULL};
 
 using CHUNK = std::vector<Job>;
 using DUMMY_DATA = std::array<CHUNK, CHUNKS_COUNT>;
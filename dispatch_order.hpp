@@ -0,0 +1,51 @@
+#ifndef DISPATCH_ORDER_HPP
+#define DISPATCH_ORDER_HPP
+
+#include "Job.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+#include <gsl/gsl>
+
+namespace dispatch_order {
+enum class Order { AS_GENERATED, LARGEST_FIRST };
+
+// LPT (longest processing time first) ordering: positions of jobs sorted by
+// estimated cost, heaviest first, so that heavy jobs start early and light
+// ones fill in the tail of the makespan. Jobs of equal cost keep their
+// relative order.
+inline std::vector<std::size_t> largest_first_positions(
+    std::span<Job const> jobs) {
+  std::vector<std::pair<std::size_t, std::size_t>> costs{};
+  costs.reserve(jobs.size());
+  for (auto const& [position, job] : std::views::enumerate(jobs)) {
+    costs.emplace_back(job.task->get_estimated_cost(),
+                       gsl::narrow_cast<std::size_t>(position));
+  }
+  std::ranges::stable_sort(costs, std::ranges::greater{},
+                           &std::pair<std::size_t, std::size_t>::first);
+
+  std::vector<std::size_t> positions{};
+  positions.reserve(jobs.size());
+  for (auto const& [cost, position] : costs) {
+    positions.push_back(position);
+  }
+  return positions;
+}
+
+// The jobs themselves in LPT order.
+inline std::vector<Job> largest_first(std::span<Job const> jobs) {
+  std::vector<Job> ordered{};
+  ordered.reserve(jobs.size());
+  for (auto const position : largest_first_positions(jobs)) {
+    ordered.push_back(jobs[position]);
+  }
+  return ordered;
+}
+}  // namespace dispatch_order
+
+#endif  // !DISPATCH_ORDER_HPP
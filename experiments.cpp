@@ -1,11 +1,58 @@
 #include "experiments.hpp"
+#include "allocation_count.hpp"
 #include "multithreading.hpp"
+#include "multithreading_barrier.hpp"
 #include "multithreading_queue.hpp"
 #include "multithreading_pool_generic.hpp"
 #include "multithreading_pool_stealing.hpp"
+#include "SharedState.hpp"
+#include "CoTask.hpp"
+#include "TaskGraph.hpp"
+#include "TaskGroup.hpp"
 
+#include <deque>
 #include <ranges>
 #include <iostream>
+#include <variant>
+
+namespace {
+// Sums up jobs by halving them, each half in a task of a TaskGroup of its
+// own, down to GRAIN_SIZE jobs; every level waits for its halves by helping
+// with them. Jobs not started once cancellation is due are left out, and
+// processed_count tells how many were not.
+template <multithreading::futurama::Scheduler S>
+Task::DUMMY_OUTPUT sum_recursively(
+    S& scheduler, std::span<Job const> jobs,
+    multithreading::futurama::Cancellation const& cancellation,
+    std::atomic<std::size_t>& processed_count) {
+  static constexpr std::size_t GRAIN_SIZE{64ULL};
+
+  Task::DUMMY_OUTPUT result{0ULL};
+  if (jobs.size() <= GRAIN_SIZE) {
+    for (auto const& job : jobs) {
+      if (cancellation.IsDue()) break;
+      result += job.task->do_stuff();
+      processed_count.fetch_add(1ULL, std::memory_order_relaxed);
+    }
+    return result;
+  }
+
+  auto const middle{jobs.size() / 2ULL};
+  Task::DUMMY_OUTPUT lower{0ULL};
+  Task::DUMMY_OUTPUT upper{0ULL};
+  multithreading::pool::TaskGroup group{scheduler, cancellation};
+  group.Spawn([&] {
+    lower = sum_recursively(scheduler, jobs.first(middle), cancellation,
+                            processed_count);
+  });
+  group.Spawn([&] {
+    upper = sum_recursively(scheduler, jobs.subspan(middle), cancellation,
+                            processed_count);
+  });
+  group.Wait();
+  return lower + upper;
+}
+}  // namespace
 
 void experiments::singlethread::process_data(config::DUMMY_DATA const& data) {
   Task::DUMMY_OUTPUT result{0ULL};
@@ -27,13 +74,18 @@ void experiments::singlethread::process_data(config::DUMMY_DATA const& data) {
 }
 
 std::vector<StatisticChunk> 
-experiments::multithread::process_data_without_queue(config::DUMMY_DATA const& data) {
+experiments::multithread::process_data_without_queue(
+    config::DUMMY_DATA const& data, std::size_t slaves_count,
+    affinity::Placement placement) {
   using namespace multithreading;
 
-  Master control_block{};
+  Master control_block{slaves_count};
   std::vector<Slave> slaves{};
-  std::generate_n(std::back_inserter(slaves), config::SLAVES_COUNT,
-                  [&control_block] { return Slave{control_block}; });
+  std::ranges::transform(
+      affinity::plan(placement, slaves_count),
+      std::back_inserter(slaves), [&control_block](auto& cpus) {
+        return Slave{control_block, std::move(cpus)};
+      });
 
   std::vector<StatisticChunk> results{};
   results.reserve(config::CHUNKS_COUNT);
@@ -41,13 +93,10 @@ experiments::multithread::process_data_without_queue(config::DUMMY_DATA const& d
   Task::DUMMY_OUTPUT result{0ULL};
   long long total_time{0LL};
   for (auto const& chunk : data) {
-    constexpr auto SLAVE_LOADOUT{config::CHUNK_SIZE / config::SLAVES_COUNT};
-    if (chunk.size() < SLAVE_LOADOUT) continue;
-
     auto const start_time_chunk{std::chrono::steady_clock::now()};
     for (auto const& [j, slave] : std::views::enumerate(slaves)) {
-      slave.set_job(
-          config::SLAVE_JOB{chunk.begin() + j * SLAVE_LOADOUT, SLAVE_LOADOUT});
+      slave.set_job(slave_share(chunk, gsl::narrow_cast<std::size_t>(j),
+                                slaves_count));
     }
     control_block.wait_for_slaves();
     for (auto const& slave : slaves) {
@@ -55,7 +104,7 @@ experiments::multithread::process_data_without_queue(config::DUMMY_DATA const& d
     }
     auto const end_time_chunk{std::chrono::steady_clock::now()};
 
-    results.emplace_back();
+    results.emplace_back(slaves_count);
     for (auto const& [j, slave] : std::views::enumerate(slaves)) {
       results.back().timing_per_thread[j] = slave.get_work_time_elapsed();
       results.back().number_of_heavy_jobs_per_thread[j] =
@@ -74,13 +123,72 @@ experiments::multithread::process_data_without_queue(config::DUMMY_DATA const& d
 }
 
 std::vector<StatisticChunk>
-experiments::multithread::process_data_with_queue(config::DUMMY_DATA const& data) {
+experiments::multithread::process_data_with_barrier(
+    config::DUMMY_DATA const& data, std::size_t slaves_count,
+    affinity::Placement placement) {
+  using namespace multithreading::barrier;
+
+  Master control_block{slaves_count};
+  auto cpus{affinity::plan(placement, slaves_count)};
+  // Slaves stay where they are built.
+  std::deque<Slave> slaves{};
+  for (auto i : std::views::iota(0ULL, slaves_count)) {
+    slaves.emplace_back(control_block, i, std::move(cpus[i]));
+  }
+
+  std::vector<StatisticChunk> results{};
+  results.reserve(config::CHUNKS_COUNT);
+
+  Task::DUMMY_OUTPUT result{0ULL};
+  long long total_time{0LL};
+  // Reports on a chunk come back when the next one is handed over.
+  std::optional<std::chrono::steady_clock::time_point> start_time_chunk{};
+  auto const advance{[&](config::SLAVE_JOB job) {
+    auto const& reports{control_block.advance(job)};
+    auto const end_time_chunk{std::chrono::steady_clock::now()};
+    if (start_time_chunk) {
+      results.emplace_back(slaves_count);
+      for (auto const& [j, report] : std::views::enumerate(reports)) {
+        result += report.output;
+        results.back().timing_per_thread[j] = report.work_time_elapsed;
+        results.back().number_of_heavy_jobs_per_thread[j] =
+            report.heavy_jobs_count;
+      }
+      auto const chunk_time{
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              end_time_chunk - *start_time_chunk)
+              .count()};
+      total_time += chunk_time;
+      results.back().total_timing = chunk_time;
+    }
+    start_time_chunk = job.empty() ? std::nullopt
+                                   : std::optional{end_time_chunk};
+  }};
+  for (auto const& chunk : data) {
+    advance(chunk);
+  }
+  advance({});
+  std::clog << "Result: " << result << " | Done in " << total_time
+            << "ms - multithread barrier\n";
+
+  return results;
+}
+
+std::vector<StatisticChunk>
+experiments::multithread::process_data_with_queue(
+    config::DUMMY_DATA const& data, std::size_t slaves_count,
+    multithreading::queue::DispensingPolicy policy,
+    dispatch_order::Order order,
+    affinity::Placement placement) {
   using namespace multithreading::queue;
 
-  Master control_block{};
+  Master control_block{slaves_count, policy};
   std::vector<Slave> slaves{};
-  std::generate_n(std::back_inserter(slaves), config::SLAVES_COUNT,
-                  [&control_block] { return Slave{control_block}; });
+  std::ranges::transform(
+      affinity::plan(placement, slaves_count),
+      std::back_inserter(slaves), [&control_block](auto& cpus) {
+        return Slave{control_block, std::move(cpus)};
+      });
 
   std::vector<StatisticChunk> results{};
   results.reserve(config::CHUNKS_COUNT);
@@ -89,7 +197,7 @@ experiments::multithread::process_data_with_queue(config::DUMMY_DATA const& data
   long long total_time{0LL};
   for (auto const& chunk : data) {
     auto const start_time_chunk{std::chrono::steady_clock::now()};
-    control_block.add_workload(chunk);
+    control_block.add_workload(chunk, order);
     for (auto& slave : slaves) {
       slave.chunk_load();
     }
@@ -99,7 +207,7 @@ experiments::multithread::process_data_with_queue(config::DUMMY_DATA const& data
     }
     auto const end_time_chunk{std::chrono::steady_clock::now()};
 
-    results.emplace_back();
+    results.emplace_back(slaves_count);
     for (auto const& [j, slave] : std::views::enumerate(slaves)) {
       results.back().timing_per_thread[j] = slave.get_work_time_elapsed();
       results.back().number_of_heavy_jobs_per_thread[j] =
@@ -117,50 +225,280 @@ experiments::multithread::process_data_with_queue(config::DUMMY_DATA const& data
   return results;
 }
 
+std::vector<StatisticChunk>
+experiments::multithread::process_data_with_queue_pipelined(
+    config::DUMMY_DATA const& data, std::size_t slaves_count,
+    std::size_t lookahead, multithreading::queue::DispensingPolicy policy,
+    dispatch_order::Order order, affinity::Placement placement) {
+  using namespace multithreading::queue;
+
+  Master control_block{slaves_count, policy};
+  control_block.start_pipeline(lookahead);
+  std::vector<Slave> slaves{};
+  std::ranges::transform(
+      affinity::plan(placement, slaves_count),
+      std::back_inserter(slaves), [&control_block](auto& cpus) {
+        return Slave{control_block, std::move(cpus)};
+      });
+
+  std::vector<StatisticChunk> results{};
+  results.reserve(config::CHUNKS_COUNT);
+
+  Task::DUMMY_OUTPUT result{0ULL};
+  long long total_time{0LL};
+  auto const collect{[&] {
+    auto report{control_block.pop_finished()};
+    if (!report) return false;
+
+    result += report->output;
+    total_time += report->stats.total_timing;
+    results.push_back(std::move(report->stats));
+    return true;
+  }};
+  auto const start_time{std::chrono::steady_clock::now()};
+  for (auto& slave : slaves) {
+    slave.chunk_load();
+  }
+  for (auto const& chunk : data) {
+    while (control_block.is_window_full()) {
+      collect();
+    }
+    control_block.push_workload(chunk, order);
+  }
+  control_block.close_pipeline();
+  while (collect()) {
+  }
+  control_block.wait_for_slaves();
+  auto const end_time{std::chrono::steady_clock::now()};
+  // Chunks overlap, so their timings add up to more than the wall time.
+  std::clog << "Result: " << result << " | Done in "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(
+                   end_time - start_time)
+                   .count()
+            << "ms (" << total_time << "ms in chunks)"
+            << " - multithread queued pipelined\n";
+
+  return results;
+}
+
 void experiments::multithread::process_data_with_pool(
-    config::DUMMY_DATA const& data) {
+    config::DUMMY_DATA const& data, std::size_t slaves_count,
+    dispatch_order::Order order, affinity::Placement placement,
+    multithreading::pool::generic::Backend backend) {
   static constexpr auto pool_adapter{
       [](Job const& task) { return task.task->do_stuff(); }};
 
   Task::DUMMY_OUTPUT result{0ULL};
+  std::vector<Job> ordered_data{};
+  if (order == dispatch_order::Order::LARGEST_FIRST) {
+    for (auto const& chunk : data) {
+      std::ranges::move(dispatch_order::largest_first(chunk),
+                        std::back_inserter(ordered_data));
+    }
+  }
+  std::chrono::steady_clock::time_point start_time{};
+  std::chrono::steady_clock::time_point end_time{};
+  auto const process{[&](auto& task_manager) {
+    auto futures{order == dispatch_order::Order::LARGEST_FIRST
+                     ? task_manager.RunBatch(ordered_data, pool_adapter)
+                     : task_manager.RunBatch(data | std::views::join,
+                                             pool_adapter)};
+    start_time = std::chrono::steady_clock::now();
+    // Chunks are summed up in the order they finish: each one posts its
+    // index to chunks_done once all of its futures are ready.
+    using CHUNK_FUTURES = std::span<typename decltype(futures)::value_type>;
+    std::vector<CHUNK_FUTURES> chunks_futures{};
+    std::vector<multithreading::futurama::Future<void>> chunks_ready{};
+    multithreading::pool::CompletionQueue<std::monostate> chunks_done{
+        data.size()};
+    auto pending_futures{CHUNK_FUTURES{futures}};
+    for (auto const& chunk : data) {
+      chunks_futures.push_back(pending_futures.first(chunk.size()));
+      chunks_ready.push_back(
+          multithreading::futurama::WhenAll(chunks_futures.back()));
+      chunks_ready.back().OnReady(
+          [&chunks_done, i = chunks_futures.size() - 1ULL] {
+            chunks_done.Push({i, std::monostate{}});
+          });
+      pending_futures = pending_futures.subspan(chunk.size());
+    }
+    for (std::size_t j{0ULL}; j < chunks_futures.size(); ++j) {
+      for (auto& futa : chunks_futures[chunks_done.Pop().index]) {
+        result += futa.Get();
+      }
+    }
+    end_time = std::chrono::steady_clock::now();
+  }};
+
+  using namespace multithreading::pool::generic;
+  if (backend == Backend::RING) {
+    RingMaster task_manager{slaves_count, placement};
+    process(task_manager);
+  } else {
+    Master task_manager{slaves_count, placement};
+    process(task_manager);
+  }
+
+  std::clog << "Result: " << result << " | Done in "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(end_time -
+                                                                     start_time).count()
+            << "ms - multithread pool\n";
+}
+
+void experiments::multithread::process_data_with_pool_bounded(
+    config::DUMMY_DATA const& data, std::size_t slaves_count,
+    multithreading::pool::generic::Backpressure backpressure,
+    dispatch_order::Order order, affinity::Placement placement,
+    multithreading::pool::generic::Backend backend) {
+  std::atomic<Task::DUMMY_OUTPUT> result{0ULL};
+  std::vector<Job> ordered_data{};
+  if (order == dispatch_order::Order::LARGEST_FIRST) {
+    for (auto const& chunk : data) {
+      std::ranges::move(dispatch_order::largest_first(chunk),
+                        std::back_inserter(ordered_data));
+    }
+  }
+  std::size_t full_count{0ULL};
+  std::chrono::steady_clock::time_point start_time{};
+  std::chrono::steady_clock::time_point end_time{};
+  auto const process{[&](auto& task_manager) {
+    start_time = std::chrono::steady_clock::now();
+    auto const submit{[&task_manager, &result, &full_count](Job const& job) {
+      auto const process_job{[&result, &job] {
+        result.fetch_add(job.task->do_stuff(), std::memory_order_relaxed);
+      }};
+      // A full pool is only counted here; Post then applies the overflow
+      // policy.
+      if (!task_manager.TrySubmit(process_job)) {
+        ++full_count;
+        task_manager.Post(process_job);
+      }
+    }};
+    if (order == dispatch_order::Order::LARGEST_FIRST) {
+      std::ranges::for_each(ordered_data, submit);
+    } else {
+      std::ranges::for_each(data | std::views::join, submit);
+    }
+    task_manager.WaitForAll();
+    end_time = std::chrono::steady_clock::now();
+  }};
+
+  using namespace multithreading::pool::generic;
+  if (backend == Backend::RING) {
+    RingMaster task_manager{slaves_count, backpressure, placement};
+    process(task_manager);
+  } else {
+    Master task_manager{slaves_count, backpressure, placement};
+    process(task_manager);
+  }
+
+  std::clog << "Result: " << result.load() << " | Done in "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(end_time -
+                                                                     start_time)
+                   .count()
+            << "ms (" << full_count << " submissions found the pool full)"
+            << " - multithread pool bounded\n";
+}
+
+void experiments::multithread::process_data_with_pool_reduce(
+    config::DUMMY_DATA const& data, std::size_t slaves_count,
+    affinity::Placement placement) {
   using namespace multithreading::pool::generic;
-  Master task_manager{config::SLAVES_COUNT};
-  auto futures{data | std::views::join | std::views::transform([&task_manager](auto&& task) {
-                 return task_manager.Run(pool_adapter, std::move(task));
-               }) |
-               std::ranges::to<std::vector>()};
+  Master task_manager{slaves_count, placement};
 
   auto const start_time{std::chrono::steady_clock::now()};
-  for (auto& futa : futures) {
-    result += futa.get();
+  Task::DUMMY_OUTPUT result{0ULL};
+  for (auto const& chunk : data) {
+    result = task_manager.ParallelTransformReduce(
+        std::span<Job const>{chunk}, result, std::plus<>{},
+        [](Job const& task) { return task.task->do_stuff(); });
   }
   auto const end_time{std::chrono::steady_clock::now()};
 
   std::clog << "Result: " << result << " | Done in "
             << std::chrono::duration_cast<std::chrono::milliseconds>(end_time -
-                                                                     start_time).count()
-            << "ms - multithread pool\n";
+                                                                     start_time)
+                   .count()
+            << "ms - multithread pool reduce\n";
 }
 
 void experiments::multithread::process_data_with_pool_dynamic(
     std::vector<Job> const& data, 
     std::size_t async_threads_count,
-    std::size_t compute_threads_count) {
+    std::size_t compute_threads_count,
+    dispatch_order::Order order,
+    affinity::Placement placement,
+    multithreading::pool::generic::Backend backend) {
   static constexpr auto pool_adapter{
       [](Job const& task) { return task.task->do_stuff(); }};
 
   Task::DUMMY_OUTPUT result{0ULL};
+  // Bulk outputs follow the dispatch order; positions maps them back to the
+  // jobs they belong to.
+  auto const positions{order == dispatch_order::Order::LARGEST_FIRST
+                           ? dispatch_order::largest_first_positions(data)
+                           : std::vector<std::size_t>{}};
+  std::vector<Task::DUMMY_OUTPUT> dispatched_outputs(positions.size());
+  std::vector<Task::DUMMY_OUTPUT> outputs(data.size());
+  std::chrono::steady_clock::time_point start_time{};
+  std::chrono::steady_clock::time_point end_time{};
+  auto const process{[&](auto& task_manager) {
+    auto done{order == dispatch_order::Order::LARGEST_FIRST
+                  ? task_manager.RunBulk(
+                        positions,
+                        [&data](std::size_t position) {
+                          return pool_adapter(data[position]);
+                        },
+                        std::span{dispatched_outputs})
+                  : task_manager.RunBulk(data, pool_adapter,
+                                         std::span{outputs})};
+    start_time = std::chrono::steady_clock::now();
+    done.Get();
+    for (auto const& [k, position] : std::views::enumerate(positions)) {
+      outputs[position] = dispatched_outputs[k];
+    }
+    for (auto const output : outputs) {
+      result += output;
+    }
+    end_time = std::chrono::steady_clock::now();
+  }};
+
   using namespace multithreading::pool::generic;
-  Master task_manager{compute_threads_count};
-  auto futures{data |
-               std::views::transform([&task_manager](auto const& task) {
-                 return task_manager.Run(pool_adapter, task);
-               }) |
-               std::ranges::to<std::vector>()};
+  if (backend == Backend::RING) {
+    RingMaster task_manager{compute_threads_count, placement};
+    process(task_manager);
+  } else {
+    Master task_manager{compute_threads_count, placement};
+    process(task_manager);
+  }
+
+  std::clog << "Result: " << result << " | Done in "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(end_time -
+                                                                     start_time)
+                   .count()
+            << "ms - multithread pool\n";
+}
+
+void experiments::multithread::process_data_with_pool_completions(
+    std::vector<Job> const& data, std::size_t compute_threads_count,
+    dispatch_order::Order order, affinity::Placement placement) {
+  static constexpr auto pool_adapter{
+      [](Job const& task) { return task.task->do_stuff(); }};
+
+  Task::DUMMY_OUTPUT result{0ULL};
+  using namespace multithreading::pool;
+  generic::Master task_manager{compute_threads_count, placement};
+  CompletionQueue<Task::DUMMY_OUTPUT> completions{data.size()};
+  if (order == dispatch_order::Order::LARGEST_FIRST) {
+    task_manager.RunBatch(dispatch_order::largest_first(data), pool_adapter,
+                          completions);
+  } else {
+    task_manager.RunBatch(data, pool_adapter, completions);
+  }
 
   auto const start_time{std::chrono::steady_clock::now()};
-  for (auto& futa : futures) {
-    result += futa.get();
+  for (std::size_t i{0ULL}; i < data.size(); ++i) {
+    result += completions.Pop().Get();
   }
   auto const end_time{std::chrono::steady_clock::now()};
 
@@ -168,11 +506,11 @@ void experiments::multithread::process_data_with_pool_dynamic(
             << std::chrono::duration_cast<std::chrono::milliseconds>(end_time -
                                                                      start_time)
                    .count()
-            << "ms - multithread pool\n";
+            << "ms - multithread pool completions\n";
 }
 
 void experiments::multithread::process_data_with_pool_stealing(
-    std::vector<Job> const& data) {
+    std::vector<Job> const& data, affinity::Placement placement) {
   using namespace multithreading::pool::stealing;
   using namespace std::chrono_literals;
 
@@ -182,21 +520,22 @@ void experiments::multithread::process_data_with_pool_stealing(
       [](Job const& task) { return task.task->do_stuff(); }};
 
   auto const logical_cores_number{std::thread::hardware_concurrency()};
-  TaskExecuter cur_exec{logical_cores_number * 5, logical_cores_number};
+  TaskExecuter cur_exec{logical_cores_number, logical_cores_number,
+                        placement};
   Task::DUMMY_OUTPUT result{0ULL};
   auto futures{
       data | std::views::transform([&](auto const& task) {
         return RunAsyncTask([&task] {
           auto tmp{SyncOn(RunAsyncTask(task_async_delay))};
-          //auto tmp{RunAsyncTask(task_async_delay).get()};
-          return RunProcessTask(pool_adapter, task).get() / tmp;
+          //auto tmp{RunAsyncTask(task_async_delay).Get()};
+          return RunProcessTask(pool_adapter, task).Get() / tmp;
         });
       }) |
       std::ranges::to<std::vector>()};
 
   auto const start_time{std::chrono::steady_clock::now()};
   for (auto& futa : futures) {
-    result += futa.get();
+    result += futa.Get();
   }
   auto const end_time{std::chrono::steady_clock::now()};
 
@@ -206,3 +545,207 @@ void experiments::multithread::process_data_with_pool_stealing(
                    .count()
             << "ms - multithread pool stealing\n";
 }
+
+void experiments::multithread::process_data_with_pool_continuations(
+    std::vector<Job> const& data, affinity::Placement placement) {
+  using namespace multithreading;
+  using namespace std::chrono_literals;
+
+  static constexpr auto task_async_delay{
+      [] { std::this_thread::sleep_for(0ms); return 2; }};
+  static constexpr auto pool_adapter{
+      [](Job const& task) { return task.task->do_stuff(); }};
+
+  auto const logical_cores_number{std::thread::hardware_concurrency()};
+  pool::stealing::TaskExecuter cur_exec{logical_cores_number,
+                                        logical_cores_number, placement};
+  Task::DUMMY_OUTPUT result{0ULL};
+  auto futures{
+      data | std::views::transform([&](auto const& task) {
+        return futurama::Async(cur_exec.async_queue, task_async_delay)
+            .Then(cur_exec.process_queue, [&task](int tmp) {
+              return pool_adapter(task) / tmp;
+            });
+      }) |
+      std::ranges::to<std::vector>()};
+
+  auto const start_time{std::chrono::steady_clock::now()};
+  for (auto& futa : futures) {
+    result += futa.Get();
+  }
+  auto const end_time{std::chrono::steady_clock::now()};
+
+  std::clog << "Result: " << result << " | Done in "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(end_time -
+                                                                     start_time)
+                   .count()
+            << "ms - multithread pool continuations\n";
+}
+
+void experiments::multithread::process_data_with_pool_coroutines(
+    std::vector<Job> const& data, affinity::Placement placement) {
+  using namespace multithreading::pool::stealing;
+  using namespace std::chrono_literals;
+
+  static constexpr auto task_async_delay{
+      [] { std::this_thread::sleep_for(0ms); return 2; }};
+  static constexpr auto pool_adapter{
+      [](Job const& task) { return task.task->do_stuff(); }};
+  static constexpr auto process_job{
+      [](Job const& task) -> CoTask<Task::DUMMY_OUTPUT> {
+        auto const tmp{co_await CoRunAsyncTask(task_async_delay)};
+        co_return co_await CoRunProcessTask(pool_adapter, task) / tmp;
+      }};
+
+  auto const logical_cores_number{std::thread::hardware_concurrency()};
+  TaskExecuter cur_exec{logical_cores_number, logical_cores_number,
+                        placement};
+  Task::DUMMY_OUTPUT result{0ULL};
+  auto coroutines{data | std::views::transform(process_job) |
+                  std::ranges::to<std::vector>()};
+
+  auto const start_time{std::chrono::steady_clock::now()};
+  for (auto& coroutine : coroutines) {
+    result += coroutine.Get();
+  }
+  auto const end_time{std::chrono::steady_clock::now()};
+
+  std::clog << "Result: " << result << " | Done in "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(end_time -
+                                                                     start_time)
+                   .count()
+            << "ms - multithread pool coroutines\n";
+}
+
+void experiments::multithread::process_data_with_task_graph(
+    std::vector<Job> const& data, affinity::Placement placement) {
+  using namespace multithreading;
+  using namespace std::chrono_literals;
+
+  static constexpr std::size_t RUNS_COUNT{3ULL};
+  static constexpr auto task_async_delay{
+      [] { std::this_thread::sleep_for(0ms); return 2; }};
+  static constexpr auto pool_adapter{
+      [](Job const& task) { return task.task->do_stuff(); }};
+
+  auto const logical_cores_number{std::thread::hardware_concurrency()};
+  pool::generic::Master task_manager{logical_cores_number, placement};
+  Task::DUMMY_OUTPUT result{0ULL};
+  std::vector<int> divisors(data.size());
+  std::vector<Task::DUMMY_OUTPUT> outputs(data.size());
+
+  // delay -> process for every job, then a single aggregate over all of them.
+  pool::TaskGraph graph{};
+  auto const aggregate{graph.Emplace([&result, &outputs] {
+    for (auto const output : outputs) {
+      result += output;
+    }
+  })};
+  for (auto const& [i, task] : std::views::enumerate(data)) {
+    auto const delay{graph.Emplace(
+        [&divisors, i] { divisors[i] = task_async_delay(); })};
+    auto const process{graph.Emplace([&divisors, &outputs, &task, i] {
+      outputs[i] = pool_adapter(task) / divisors[i];
+    })};
+    graph.Precede(delay, process);
+    graph.Precede(process, aggregate);
+  }
+
+  // The graph is built once and run again for every round.
+  for (std::size_t run{0ULL}; run < RUNS_COUNT; ++run) {
+    result = 0ULL;
+    auto const start_time{std::chrono::steady_clock::now()};
+    graph.Run(task_manager);
+    auto const end_time{std::chrono::steady_clock::now()};
+
+    std::clog << "Result: " << result << " | Run " << run << " done in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(
+                     end_time - start_time)
+                     .count()
+              << "ms - multithread task graph\n";
+  }
+}
+
+void experiments::multithread::count_pool_allocations(
+    std::vector<Job> const& data, affinity::Placement placement) {
+  using namespace multithreading;
+  using namespace std::chrono_literals;
+
+  static constexpr std::size_t ROUNDS_COUNT{4ULL};
+  // Jobs in flight at a time, well within the capacity of the block caches.
+  static constexpr std::size_t WAVE_SIZE{100ULL};
+  static constexpr auto task_async_delay{
+      [] { std::this_thread::sleep_for(0ms); return 2; }};
+  static constexpr auto pool_adapter{
+      [](Job const& task) { return task.task->do_stuff(); }};
+
+  allocation_count::enable();
+  auto const logical_cores_number{std::thread::hardware_concurrency()};
+  std::vector<futurama::Future<Task::DUMMY_OUTPUT>> futures{};
+  futures.reserve(WAVE_SIZE);
+  auto const count_rounds{[&futures, &data](std::string_view pool_name,
+                                            auto const& submit) {
+    for (std::size_t round{0ULL}; round < ROUNDS_COUNT; ++round) {
+      Task::DUMMY_OUTPUT result{0ULL};
+      auto const allocations_before{allocation_count::get()};
+      for (std::size_t begin{0ULL}; begin < data.size(); begin += WAVE_SIZE) {
+        for (auto const& task : std::span{data}.subspan(
+                 begin, std::min(WAVE_SIZE, data.size() - begin))) {
+          futures.push_back(submit(task));
+        }
+        for (auto& futa : futures) {
+          result += futa.Get();
+        }
+        futures.clear();
+      }
+      std::clog << "Result: " << result << " | Round " << round << ": "
+                << allocation_count::get() - allocations_before
+                << " allocations - " << pool_name << '\n';
+    }
+  }};
+
+  {
+    pool::generic::Master task_manager{logical_cores_number, placement};
+    count_rounds("multithread pool", [&task_manager](Job const& task) {
+      return task_manager.Run(pool_adapter, std::cref(task));
+    });
+  }
+  {
+    // Tasks and states travel between the submitting thread and the slaves
+    // of both queues, so most blocks are freed by another thread.
+    pool::stealing::TaskExecuter cur_exec{logical_cores_number,
+                                          logical_cores_number, placement};
+    count_rounds("multithread pool continuations",
+                 [&cur_exec](Job const& task) {
+                   return futurama::Async(cur_exec.async_queue,
+                                          task_async_delay)
+                       .Then(cur_exec.process_queue, [&task](int tmp) {
+                         return pool_adapter(task) / tmp;
+                       });
+                 });
+  }
+}
+
+void experiments::multithread::process_data_with_task_groups(
+    std::vector<Job> const& data, std::size_t compute_threads_count,
+    std::chrono::milliseconds time_budget, affinity::Placement placement) {
+  using namespace multithreading;
+
+  pool::generic::Master task_manager{compute_threads_count, placement};
+  std::atomic<std::size_t> processed_count{0ULL};
+  auto const start_time{std::chrono::steady_clock::now()};
+  futurama::Cancellation cancellation{};
+  if (time_budget.count() > 0) {
+    cancellation.deadline = start_time + time_budget;
+  }
+  auto const result{sum_recursively(task_manager, std::span{data},
+                                    cancellation, processed_count)};
+  auto const end_time{std::chrono::steady_clock::now()};
+
+  std::clog << "Result: " << result << " | Done in "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(end_time -
+                                                                     start_time)
+                   .count()
+            << "ms (" << processed_count.load() << " of " << data.size()
+            << " jobs) - multithread task groups\n";
+}
@@ -2,20 +2,100 @@
 #define EXPERIMENTS_HPP
 
 #include "StatisticChunk.hpp"
+#include "affinity.hpp"
+#include "dispatch_order.hpp"
+#include "multithreading_pool_generic.hpp"
+#include "multithreading_queue.hpp"
 
 namespace experiments {
 namespace singlethread {
 void process_data(config::DUMMY_DATA const& data);
 }
 namespace multithread {
-std::vector<StatisticChunk> process_data_without_queue(config::DUMMY_DATA const& data);
-std::vector<StatisticChunk> process_data_with_queue(config::DUMMY_DATA const& data);
-void process_data_with_pool(config::DUMMY_DATA const& data);
+std::vector<StatisticChunk> process_data_without_queue(
+    config::DUMMY_DATA const& data,
+    std::size_t slaves_count = config::DEFAULT_SLAVES_COUNT,
+    affinity::Placement placement = affinity::Placement::NONE);
+std::vector<StatisticChunk> process_data_with_barrier(
+    config::DUMMY_DATA const& data,
+    std::size_t slaves_count = config::DEFAULT_SLAVES_COUNT,
+    affinity::Placement placement = affinity::Placement::NONE);
+std::vector<StatisticChunk> process_data_with_queue(
+    config::DUMMY_DATA const& data,
+    std::size_t slaves_count = config::DEFAULT_SLAVES_COUNT,
+    multithreading::queue::DispensingPolicy policy =
+        multithreading::queue::DispensingPolicy::SINGLE,
+    dispatch_order::Order order = dispatch_order::Order::AS_GENERATED,
+    affinity::Placement placement = affinity::Placement::NONE);
+// Slaves flow from one chunk into the next with up to lookahead chunks
+// queued ahead; see multithreading::queue::Master::start_pipeline.
+std::vector<StatisticChunk> process_data_with_queue_pipelined(
+    config::DUMMY_DATA const& data, std::size_t slaves_count,
+    std::size_t lookahead,
+    multithreading::queue::DispensingPolicy policy =
+        multithreading::queue::DispensingPolicy::SINGLE,
+    dispatch_order::Order order = dispatch_order::Order::AS_GENERATED,
+    affinity::Placement placement = affinity::Placement::NONE);
+void process_data_with_pool(
+    config::DUMMY_DATA const& data,
+    std::size_t slaves_count = config::DEFAULT_SLAVES_COUNT,
+    dispatch_order::Order order = dispatch_order::Order::AS_GENERATED,
+    affinity::Placement placement = affinity::Placement::NONE,
+    multithreading::pool::generic::Backend backend =
+        multithreading::pool::generic::Backend::LOCKED);
+// Streams the jobs into a pool with bounded queueing instead of submitting
+// them all at once; no per-job handles are kept.
+void process_data_with_pool_bounded(
+    config::DUMMY_DATA const& data, std::size_t slaves_count,
+    multithreading::pool::generic::Backpressure backpressure,
+    dispatch_order::Order order = dispatch_order::Order::AS_GENERATED,
+    affinity::Placement placement = affinity::Placement::NONE,
+    multithreading::pool::generic::Backend backend =
+        multithreading::pool::generic::Backend::LOCKED);
+void process_data_with_pool_reduce(
+    config::DUMMY_DATA const& data,
+    std::size_t slaves_count = config::DEFAULT_SLAVES_COUNT,
+    affinity::Placement placement = affinity::Placement::NONE);
 
-void process_data_with_pool_dynamic(std::vector<Job> const& data,
-                                    std::size_t async_threads_count,
-                                    std::size_t compute_threads_count);
-void process_data_with_pool_stealing(std::vector<Job> const& data);
+void process_data_with_pool_dynamic(
+    std::vector<Job> const& data, std::size_t async_threads_count,
+    std::size_t compute_threads_count,
+    dispatch_order::Order order = dispatch_order::Order::AS_GENERATED,
+    affinity::Placement placement = affinity::Placement::NONE,
+    multithreading::pool::generic::Backend backend =
+        multithreading::pool::generic::Backend::LOCKED);
+// Like process_data_with_pool_dynamic, with results summed in the order they
+// finish, drained from a multithreading::pool::CompletionQueue.
+void process_data_with_pool_completions(
+    std::vector<Job> const& data, std::size_t compute_threads_count,
+    dispatch_order::Order order = dispatch_order::Order::AS_GENERATED,
+    affinity::Placement placement = affinity::Placement::NONE);
+void process_data_with_pool_stealing(
+    std::vector<Job> const& data,
+    affinity::Placement placement = affinity::Placement::NONE);
+void process_data_with_pool_continuations(
+    std::vector<Job> const& data,
+    affinity::Placement placement = affinity::Placement::NONE);
+void process_data_with_pool_coroutines(
+    std::vector<Job> const& data,
+    affinity::Placement placement = affinity::Placement::NONE);
+// The stealing experiment's chain of jobs as a multithreading::pool::TaskGraph
+// on the generic pool, so no task blocks on another one.
+void process_data_with_task_graph(
+    std::vector<Job> const& data,
+    affinity::Placement placement = affinity::Placement::NONE);
+// Recursive halving of the jobs with nested multithreading::pool::TaskGroup
+// scopes. With a non-zero time_budget, jobs not started by then are skipped.
+void process_data_with_task_groups(
+    std::vector<Job> const& data, std::size_t compute_threads_count,
+    std::chrono::milliseconds time_budget = std::chrono::milliseconds{0},
+    affinity::Placement placement = affinity::Placement::NONE);
+// Runs the jobs through both pools a few rounds in a row and reports the
+// calls to operator new of each round; past the first one, which warms the
+// block caches up, there should be none.
+void count_pool_allocations(
+    std::vector<Job> const& data,
+    affinity::Placement placement = affinity::Placement::NONE);
 }
 }
 
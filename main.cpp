@@ -1,3 +1,4 @@
+#include "allocation_count.hpp"
 #include "argparse/argparse.hpp"
 #include "cmd_args.hpp"
 #include "config.hpp"
@@ -31,8 +32,91 @@ int main(int argc, char const* argv[]) {
     .nargs(1)
     .scan<'u', std::size_t>()
     .default_value(config::PoolParams::DEFAULT_HEAVY_TASKS_COUNT);
+  program.at(cmd_args::QUEUE_DISPENSING)
+    .nargs(1)
+    .default_value(std::string{cmd_args::queue_dispensing::SINGLE})
+    .choices(cmd_args::queue_dispensing::SINGLE,
+             cmd_args::queue_dispensing::FIXED_CHUNK,
+             cmd_args::queue_dispensing::GUIDED,
+             cmd_args::queue_dispensing::FACTORING,
+             cmd_args::queue_dispensing::TRAPEZOID);
+  program.at(cmd_args::SLAVES_COUNT)
+    .nargs(1)
+    .scan<'u', std::size_t>()
+    .default_value(config::DEFAULT_SLAVES_COUNT);
+  program.at(cmd_args::QUEUE_LOOKAHEAD)
+    .nargs(1)
+    .scan<'u', std::size_t>()
+    .default_value(std::size_t{0ULL});
+  program.at(cmd_args::POOL_CAPACITY)
+    .nargs(1)
+    .scan<'u', std::size_t>()
+    .default_value(std::size_t{0ULL});
+  program.at(cmd_args::POOL_OVERFLOW)
+    .nargs(1)
+    .default_value(std::string{cmd_args::pool_overflow::BLOCK})
+    .choices(cmd_args::pool_overflow::BLOCK,
+             cmd_args::pool_overflow::CALLER_RUNS);
+  program.at(cmd_args::POOL_BACKEND)
+    .nargs(1)
+    .default_value(std::string{cmd_args::pool_backend::LOCKED})
+    .choices(cmd_args::pool_backend::LOCKED,
+             cmd_args::pool_backend::RING);
+  program.at(cmd_args::TIME_BUDGET_MS)
+    .nargs(1)
+    .scan<'u', std::size_t>()
+    .default_value(std::size_t{0ULL});
+  program.at(cmd_args::PLACEMENT)
+    .nargs(1)
+    .default_value(std::string{cmd_args::placement::NONE})
+    .choices(cmd_args::placement::NONE,
+             cmd_args::placement::COMPACT,
+             cmd_args::placement::SCATTER,
+             cmd_args::placement::PHYSICAL_CORES,
+             cmd_args::placement::NUMA_NODES);
   program.parse_args(argc, argv);
 
+  auto const queue_dispensing_name{
+      program.get<std::string>(cmd_args::QUEUE_DISPENSING)};
+  auto const queue_dispensing{[&queue_dispensing_name] {
+    using enum multithreading::queue::DispensingPolicy;
+    namespace names = cmd_args::queue_dispensing;
+    if (queue_dispensing_name == names::FIXED_CHUNK) return FIXED_CHUNK;
+    if (queue_dispensing_name == names::GUIDED) return GUIDED;
+    if (queue_dispensing_name == names::FACTORING) return FACTORING;
+    if (queue_dispensing_name == names::TRAPEZOID) return TRAPEZOID;
+    return SINGLE;
+  }()};
+  auto const placement_name{program.get<std::string>(cmd_args::PLACEMENT)};
+  auto const placement{[&placement_name] {
+    using enum affinity::Placement;
+    namespace names = cmd_args::placement;
+    if (placement_name == names::COMPACT) return COMPACT;
+    if (placement_name == names::SCATTER) return SCATTER;
+    if (placement_name == names::PHYSICAL_CORES) return PHYSICAL_CORES;
+    if (placement_name == names::NUMA_NODES) return NUMA_NODES;
+    return NONE;
+  }()};
+  auto const pool_backpressure{[&program] {
+    using namespace multithreading::pool::generic;
+    return Backpressure{
+        .capacity = program.get<std::size_t>(cmd_args::POOL_CAPACITY),
+        .policy = program.get<std::string>(cmd_args::POOL_OVERFLOW) ==
+                          cmd_args::pool_overflow::CALLER_RUNS
+                      ? OverflowPolicy::CALLER_RUNS
+                      : OverflowPolicy::BLOCK};
+  }()};
+  auto const pool_backend{
+      program.get<std::string>(cmd_args::POOL_BACKEND) ==
+              cmd_args::pool_backend::RING
+          ? multithreading::pool::generic::Backend::RING
+          : multithreading::pool::generic::Backend::LOCKED};
+  auto const slaves_count{std::max(
+      program.get<std::size_t>(cmd_args::SLAVES_COUNT), std::size_t{1})};
+  auto const order{program[cmd_args::LARGEST_FIRST] == true
+                       ? dispatch_order::Order::LARGEST_FIRST
+                       : dispatch_order::Order::AS_GENERATED};
+
   auto const process_dataset{[&](auto dataset,
                                  std::string const& filename_suffix) {
     static std::string const BASE_FILENAME{"timings"};
@@ -40,6 +124,15 @@ int main(int argc, char const* argv[]) {
 
     using namespace std::string_literals;
 
+    auto const placement_suffix{
+        placement_name == cmd_args::placement::NONE
+            ? ""s
+            : FILENAME_SEPARATOR + placement_name};
+    auto const slaves_suffix{
+        slaves_count == config::DEFAULT_SLAVES_COUNT
+            ? ""s
+            : FILENAME_SEPARATOR + std::to_string(slaves_count) + "t"s};
+
     if (program[cmd_args::USE_SINGLETHREADING] == true) {
       std::clog << "Singlethreading starts...\n";
       experiments::singlethread::process_data(dataset);
@@ -47,22 +140,67 @@ int main(int argc, char const* argv[]) {
     if (program[cmd_args::USE_MULTITHREADING] == true) {
       std::clog << "Multithreading starts...\n";
       auto const stats{
-          experiments::multithread::process_data_without_queue(dataset)};
+          experiments::multithread::process_data_without_queue(
+              dataset, slaves_count, placement)};
       StatisticChunk::save_as_csv(stats, BASE_FILENAME + FILENAME_SEPARATOR +
                                              filename_suffix +
-                                             FILENAME_SEPARATOR + "nq"s);
+                                             FILENAME_SEPARATOR + "nq"s +
+                                             slaves_suffix + placement_suffix);
+    }
+    if (program[cmd_args::USE_MULTITHREADING_BARRIER] == true) {
+      std::clog << "Multithreading barrier starts...\n";
+      auto const stats{
+          experiments::multithread::process_data_with_barrier(
+              dataset, slaves_count, placement)};
+      StatisticChunk::save_as_csv(stats, BASE_FILENAME + FILENAME_SEPARATOR +
+                                             filename_suffix +
+                                             FILENAME_SEPARATOR + "nq"s +
+                                             FILENAME_SEPARATOR + "barrier"s +
+                                             slaves_suffix + placement_suffix);
     }
     if (program[cmd_args::USE_MULTITHREADING_QUEUE] == true) {
       std::clog << "Multithreading queue starts...\n";
+      auto const lookahead{program.get<std::size_t>(cmd_args::QUEUE_LOOKAHEAD)};
       auto const stats{
-          experiments::multithread::process_data_with_queue(dataset)};
+          lookahead == 0ULL
+              ? experiments::multithread::process_data_with_queue(
+                    dataset, slaves_count, queue_dispensing, order, placement)
+              : experiments::multithread::process_data_with_queue_pipelined(
+                    dataset, slaves_count, lookahead, queue_dispensing, order,
+                    placement)};
+      auto const policy_suffix{
+          queue_dispensing_name == cmd_args::queue_dispensing::SINGLE
+              ? ""s
+              : FILENAME_SEPARATOR + queue_dispensing_name};
+      auto const order_suffix{order == dispatch_order::Order::LARGEST_FIRST
+                                  ? FILENAME_SEPARATOR + "lpt"s
+                                  : ""s};
+      auto const lookahead_suffix{
+          lookahead == 0ULL
+              ? ""s
+              : FILENAME_SEPARATOR + "la"s + std::to_string(lookahead)};
       StatisticChunk::save_as_csv(stats, BASE_FILENAME + FILENAME_SEPARATOR +
                                              filename_suffix +
-                                             FILENAME_SEPARATOR + "q"s);
+                                             FILENAME_SEPARATOR + "q"s +
+                                             policy_suffix + order_suffix +
+                                             lookahead_suffix + slaves_suffix +
+                                             placement_suffix);
     }
     if (program[cmd_args::USE_MULTITHREADING_POOL] == true) {
       std::clog << "Multithreading pool starts...\n";
-      experiments::multithread::process_data_with_pool(dataset);
+      if (pool_backpressure.capacity == 0ULL) {
+        experiments::multithread::process_data_with_pool(
+            dataset, slaves_count, order, placement, pool_backend);
+      } else {
+        experiments::multithread::process_data_with_pool_bounded(
+            dataset, slaves_count, pool_backpressure, order, placement,
+            pool_backend);
+      }
+    }
+    if (program[cmd_args::USE_MULTITHREADING_POOL_REDUCE] == true) {
+      std::clog << "Multithreading pool reduce starts...\n";
+      experiments::multithread::process_data_with_pool_reduce(
+          dataset, slaves_count, placement);
     }
   }};
 
@@ -81,14 +219,73 @@ int main(int argc, char const* argv[]) {
             program.get<std::size_t>(cmd_args::DATASET_SIZE),
             program.get<std::size_t>(cmd_args::HEAVY_TASKS_COUNT)),
         program.get<std::size_t>(cmd_args::ASYNC_THREADS_COUNT),
-        program.get<std::size_t>(cmd_args::COMPUTE_THREADS_COUNT));
+        program.get<std::size_t>(cmd_args::COMPUTE_THREADS_COUNT), order,
+        placement, pool_backend);
+  }
+  if (program[cmd_args::USE_MULTITHREADING_COMPLETIONS] == true) {
+    std::clog << "Processing data dynamic configured in completion order...\n";
+    experiments::multithread::process_data_with_pool_completions(
+        data_generation::get_dynamic(
+            program.get<std::size_t>(cmd_args::DATASET_SIZE),
+            program.get<std::size_t>(cmd_args::HEAVY_TASKS_COUNT)),
+        program.get<std::size_t>(cmd_args::COMPUTE_THREADS_COUNT), order,
+        placement);
   }
   if (program[cmd_args::USE_MULTITHREADING_STEALING] == true) {
     std::clog << "Processing data dynamic configured...\n";
     experiments::multithread::process_data_with_pool_stealing(
       data_generation::get_dynamic(
         program.get<std::size_t>(cmd_args::DATASET_SIZE),
-        program.get<std::size_t>(cmd_args::HEAVY_TASKS_COUNT)));
+        program.get<std::size_t>(cmd_args::HEAVY_TASKS_COUNT)),
+      placement);
+  }
+  if (program[cmd_args::USE_MULTITHREADING_CONTINUATIONS] == true) {
+    std::clog << "Processing data with continuations...\n";
+    experiments::multithread::process_data_with_pool_continuations(
+      data_generation::get_dynamic(
+        program.get<std::size_t>(cmd_args::DATASET_SIZE),
+        program.get<std::size_t>(cmd_args::HEAVY_TASKS_COUNT)),
+      placement);
+  }
+  if (program[cmd_args::USE_MULTITHREADING_COROUTINES] == true) {
+    std::clog << "Processing data with coroutines...\n";
+    experiments::multithread::process_data_with_pool_coroutines(
+      data_generation::get_dynamic(
+        program.get<std::size_t>(cmd_args::DATASET_SIZE),
+        program.get<std::size_t>(cmd_args::HEAVY_TASKS_COUNT)),
+      placement);
+  }
+  if (program[cmd_args::USE_MULTITHREADING_GRAPH] == true) {
+    std::clog << "Processing data with a task graph...\n";
+    experiments::multithread::process_data_with_task_graph(
+      data_generation::get_dynamic(
+        program.get<std::size_t>(cmd_args::DATASET_SIZE),
+        program.get<std::size_t>(cmd_args::HEAVY_TASKS_COUNT)),
+      placement);
+  }
+  if (program[cmd_args::USE_MULTITHREADING_TASK_GROUPS] == true) {
+    std::clog << "Processing data with nested task groups...\n";
+    experiments::multithread::process_data_with_task_groups(
+      data_generation::get_dynamic(
+        program.get<std::size_t>(cmd_args::DATASET_SIZE),
+        program.get<std::size_t>(cmd_args::HEAVY_TASKS_COUNT)),
+      program.get<std::size_t>(cmd_args::COMPUTE_THREADS_COUNT),
+      std::chrono::milliseconds{
+        program.get<std::size_t>(cmd_args::TIME_BUDGET_MS)},
+      placement);
+  }
+  if (program[cmd_args::COUNT_ALLOCATIONS] == true &&
+      !allocation_count::IS_AVAILABLE) {
+    std::clog << cmd_args::COUNT_ALLOCATIONS
+              << " needs a build with MULTITHREADING_COUNT_ALLOCATIONS "
+                 "defined\n";
+  } else if (program[cmd_args::COUNT_ALLOCATIONS] == true) {
+    std::clog << "Counting allocations of the pools...\n";
+    experiments::multithread::count_pool_allocations(
+      data_generation::get_dynamic(
+        program.get<std::size_t>(cmd_args::DATASET_SIZE),
+        program.get<std::size_t>(cmd_args::HEAVY_TASKS_COUNT)),
+      placement);
   }
 
   return EXIT_SUCCESS;
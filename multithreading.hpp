@@ -3,7 +3,9 @@
 
 #include "Job.hpp"
 #include "StatisticChunk.hpp"
+#include "affinity.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <mutex>
 
@@ -12,14 +14,29 @@ using SLAVE_JOB = std::span<Job const>;
 }
 
 namespace multithreading {
+// Share of chunk for slave slave_id out of slaves_count: contiguous and as
+// even as possible, the first chunk.size() % slaves_count slaves taking one
+// job more.
+inline config::SLAVE_JOB slave_share(config::SLAVE_JOB chunk,
+                                     std::size_t slave_id,
+                                     std::size_t slaves_count) {
+  auto const loadout{chunk.size() / slaves_count};
+  auto const remainder{chunk.size() % slaves_count};
+  return chunk.subspan(slave_id * loadout + std::min(slave_id, remainder),
+                       loadout + (slave_id < remainder ? 1ULL : 0ULL));
+}
+
 class Master {
  public:
+  explicit Master(std::size_t slaves_count_init)
+      : slaves_count{slaves_count_init} {}
+
   void job_is_done() {
     bool notification_needed{false};
     {
       std::lock_guard lock{mtx};
       ++slaves_finished_job_count;
-      notification_needed = slaves_finished_job_count == config::SLAVES_COUNT;
+      notification_needed = slaves_finished_job_count == slaves_count;
     }
     if (notification_needed) {
       cv.notify_one();
@@ -28,7 +45,7 @@ class Master {
 
   void wait_for_slaves() {
     cv.wait(lock, [this] {
-      return slaves_finished_job_count == config::SLAVES_COUNT;
+      return slaves_finished_job_count == slaves_count;
     });
     slaves_finished_job_count = 0ull;
   }
@@ -38,20 +55,26 @@ class Master {
   std::mutex mtx{};
   std::unique_lock<std::mutex> lock{mtx};
 
+  std::size_t const slaves_count;
+
   std::size_t slaves_finished_job_count{0ULL};
 };
 
 class Slave {
  public:
-  Slave(Master& control_block_init)
-      : control_block{control_block_init}, process{&Slave::run, this} {}
+  Slave(Master& control_block_init, affinity::CPU_LIST cpus_init = {})
+      : cpus{std::move(cpus_init)},
+        control_block{control_block_init},
+        process{&Slave::run, this} {}
 
-  Slave(Slave&& slave_tmp) noexcept : Slave{slave_tmp.control_block} {}
+  Slave(Slave&& slave_tmp) noexcept
+      : Slave{slave_tmp.control_block, slave_tmp.cpus} {}
 
   ~Slave() { kill(); }
 
   void set_job(config::SLAVE_JOB data_to_process) {
-    std::ignore = std::lock_guard{mtx}, data = data_to_process, dying = false;
+    std::ignore = std::lock_guard{mtx}, data = data_to_process,
+                  has_job = true, dying = false;
     cv.notify_one();
   }
 
@@ -68,10 +91,12 @@ class Slave {
 
  private:
   void run() {
+    affinity::pin_current_thread(cpus);
     std::unique_lock lock{mtx};
 
     while (true) {
-      cv.wait(lock, [this] { return !data.empty() || dying; });
+      // A slave with an empty share reports back all the same.
+      cv.wait(lock, [this] { return has_job || dying; });
 
       if (dying) break;
 
@@ -91,6 +116,7 @@ class Slave {
                               .count();
 
       data = {};
+      has_job = false;
       control_block.job_is_done();
     }
   }
@@ -99,14 +125,18 @@ class Slave {
   std::condition_variable cv{};
   std::mutex mtx{};
 
-  std::jthread process;
+  affinity::CPU_LIST const cpus;
 
   Master& control_block;
   config::SLAVE_JOB data{};
   Task::DUMMY_OUTPUT output{};
+  bool has_job{false};
   bool dying{false};
   long long work_time_elapsed{};
   std::size_t heavy_jobs_count{};
+
+  // Started last, once everything run() touches is initialised.
+  std::jthread process;
 };
 }  // namespace multithreading
 
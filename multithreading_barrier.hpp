@@ -0,0 +1,144 @@
+#ifndef MULTITHREADING_BARRIER_HPP
+#define MULTITHREADING_BARRIER_HPP
+
+#include "Job.hpp"
+#include "StatisticChunk.hpp"
+#include "affinity.hpp"
+#include "multithreading.hpp"
+
+#include <barrier>
+#include <chrono>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <gsl/gsl>
+
+namespace multithreading::barrier {
+struct SlaveReport {
+  Task::DUMMY_OUTPUT output{};
+  long long work_time_elapsed{};
+  std::size_t heavy_jobs_count{};
+};
+
+using SLAVE_REPORTS = std::vector<SlaveReport>;
+
+// Every chunk costs a single std::barrier phase: the caller publishes the next
+// chunk in the epoch slot and arrives, slaves arrive as they finish the
+// current one, and the completion step, run by the last one to arrive, moves
+// the slot on and keeps the slaves' reports on the chunk just finished. The
+// caller reads those while the slaves are busy with the next chunk.
+class Master {
+ public:
+  struct Epoch {
+    config::SLAVE_JOB job{};
+    bool dying{false};
+  };
+
+  explicit Master(std::size_t slaves_count_init)
+      : reports(slaves_count_init),
+        finished_reports(slaves_count_init),
+        sync_point{gsl::narrow_cast<std::ptrdiff_t>(slaves_count_init + 1ULL),
+                   NextEpoch{this}} {}
+
+  // Hands job over to the slaves once they are done with the current one and
+  // returns their reports on it; they stay valid until the next call. An
+  // empty job lets the slaves idle for an epoch.
+  SLAVE_REPORTS const& advance(config::SLAVE_JOB job) {
+    next_epoch = {.job = job};
+    sync_point.arrive_and_wait();
+    return finished_reports;
+  }
+
+  void dismiss() {
+    if (std::exchange(dismissed, true)) return;
+
+    next_epoch = {.dying = true};
+    sync_point.arrive_and_wait();
+  }
+
+  void wait_for_epoch() { sync_point.arrive_and_wait(); }
+
+  Epoch const& get_epoch() const { return cur_epoch; }
+
+  SlaveReport& get_report(std::size_t slave_id) { return reports[slave_id]; }
+
+  std::size_t get_slaves_count() const { return reports.size(); }
+
+ private:
+  struct NextEpoch {
+    void operator()() noexcept {
+      master->cur_epoch = master->next_epoch;
+      master->finished_reports = master->reports;
+    }
+
+    Master* master;
+  };
+
+  Epoch next_epoch{};
+  Epoch cur_epoch{};
+  SLAVE_REPORTS reports{};
+  SLAVE_REPORTS finished_reports{};
+  bool dismissed{false};
+
+  // The slaves and the caller.
+  std::barrier<NextEpoch> sync_point;
+};
+
+class Slave {
+ public:
+  Slave(Master& control_block_init, std::size_t id_init,
+        affinity::CPU_LIST cpus_init = {})
+      : cpus{std::move(cpus_init)},
+        id{id_init},
+        control_block{control_block_init} {}
+
+  // The running thread keeps using this, and the barrier is sized for a
+  // fixed set of slaves, so a slave can be neither moved nor rebuilt.
+  Slave(Slave&&) = delete;
+  Slave& operator=(Slave&&) = delete;
+
+  // The slaves leave the barrier all together, so the first one destroyed
+  // dismisses every one of them.
+  ~Slave() {
+    if (process.joinable()) control_block.dismiss();
+  }
+
+ private:
+  void run() {
+    affinity::pin_current_thread(cpus);
+    while (true) {
+      control_block.wait_for_epoch();
+      auto const& epoch{control_block.get_epoch()};
+      if (epoch.dying) break;
+
+      auto& report{control_block.get_report(id)};
+      report = {};
+      auto const data{
+          slave_share(epoch.job, id, control_block.get_slaves_count())};
+
+      auto const start_time_data{std::chrono::steady_clock::now()};
+      for (auto const& dummy_process : data) {
+        report.output += dummy_process.task->do_stuff();
+      }
+      auto const end_time_data{std::chrono::steady_clock::now()};
+      for (auto const& dummy_process : data) {
+        if (typeid(*dummy_process.task.get()) == typeid(HeavyTask const&))
+          ++report.heavy_jobs_count;
+      }
+      report.work_time_elapsed =
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              end_time_data - start_time_data)
+              .count();
+    }
+  }
+
+ private:
+  affinity::CPU_LIST cpus;
+  std::size_t id;
+  Master& control_block;
+
+  std::jthread process{&Slave::run, this};
+};
+}  // namespace multithreading::barrier
+
+#endif  // !MULTITHREADING_BARRIER_HPP
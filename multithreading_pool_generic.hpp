@@ -1,104 +1,737 @@
 #ifndef MULTITHREADING_POOL_GENERIC_HPP
 #define MULTITHREADING_POOL_GENERIC_HPP
 
+#include "AdaptiveWait.hpp"
+#include "BatchSizer.hpp"
+#include "CompletionQueue.hpp"
+#include "affinity.hpp"
+#include "InlineTask.hpp"
+#include "LockedQueue.hpp"
+#include "RingQueue.hpp"
+#include "SharedState.hpp"
+
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <cassert>
-#include <condition_variable>
+#include <chrono>
+#include <concepts>
+#include <exception>
 #include <functional>
-#include <future>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <queue>
 #include <ranges>
+#include <span>
 #include <thread>
 #include <utility>
+#include <variant>
 #include <vector>
+#include <gsl/gsl>
 
 namespace multithreading::pool::generic {
+enum class Priority : std::size_t { HIGH, NORMAL, LOW };
+
+enum class OverflowPolicy { BLOCK, CALLER_RUNS };
 
-class Master {
+// Caps the number of tasks queued in the pool, running ones aside; zero
+// capacity means unbounded. Once the pool is at capacity a submission either
+// blocks until slaves have taken enough tasks (BLOCK), or runs the tasks that
+// did not fit on the calling thread (CALLER_RUNS). A slave submitting to its
+// own full pool runs queued tasks instead of blocking, so nested submissions
+// cannot deadlock.
+struct Backpressure {
+  std::size_t capacity{0ULL};
+  OverflowPolicy policy{OverflowPolicy::BLOCK};
+};
+
+// TasksQueue is the storage backend of the pool. It has to provide
+// std::size_t TryPushBulk(std::span<T>), moving out the longest prefix it has
+// room for and returning its length, std::optional<T> TryPop() and
+// std::size_t TryPopBulk(std::vector<T>&, std::size_t max_count), appending up
+// to max_count items; all of them safe to call from any thread. Slaves are
+// parked only when the backend has run out of tasks.
+// Every Priority has its own lane (a TasksQueue of its own, built from the
+// same queue_args as the others). Slaves serve the highest non-empty lane,
+// except that a lower lane which has waited while AGING_THRESHOLD tasks were
+// taken from above it is served next, so no lane can starve. While only one
+// lane has ever been used, picking a lane costs a single relaxed load.
+template <template <class> class TasksQueue>
+class BasicMaster {
  private:
+  using TaskT = InlineTask;
+
   class Slave {
    public:
-    Slave(Master& tasks_pool) : tasks_pool_{tasks_pool} {}
+    Slave(BasicMaster& tasks_pool, std::size_t id, affinity::CPU_LIST cpus)
+        : tasks_pool_{tasks_pool}, id_{id}, cpus_{std::move(cpus)} {}
 
     void Kill() noexcept { cur_thread_.request_stop(); }
 
    private:
     void KernelRoutine(std::stop_token const& st) const noexcept {
-      while (auto cur_task{tasks_pool_.GetTask(st)}) {
-        cur_task();
+      affinity::pin_current_thread(cpus_);
+      this_master_ = &tasks_pool_;
+      this_slave_id_ = id_;
+      std::vector<TaskT> batch{};
+      batch.reserve(BatchSizer::MAX_BATCH_SIZE);
+      BatchSizer sizer{};
+      AdaptiveWait waiter{};
+      while (tasks_pool_.GetTasks(st, batch, sizer, waiter)) {
+        auto const start_time{std::chrono::steady_clock::now()};
+        for (auto& cur_task : batch) {
+          cur_task();
+        }
+        sizer.Record(batch.size(), std::chrono::steady_clock::now() - start_time);
+        tasks_pool_.TasksFinished(batch.size());
+        batch.clear();
       }
     }
 
    private:
-    Master& tasks_pool_;
+    BasicMaster& tasks_pool_;
+    std::size_t id_;
+    affinity::CPU_LIST cpus_;
 
     std::jthread cur_thread_{std::bind_front(&Slave::KernelRoutine, this)};
   };
 
  public:
-  Master(std::size_t slaves_count) noexcept {
+  template <typename... QueueArgs>
+  BasicMaster(std::size_t slaves_count,
+              affinity::Placement placement = affinity::Placement::NONE,
+              QueueArgs&&... queue_args) noexcept
+      : BasicMaster(slaves_count, Backpressure{}, placement,
+                    std::forward<QueueArgs>(queue_args)...) {}
+
+  template <typename... QueueArgs>
+  BasicMaster(std::size_t slaves_count, Backpressure backpressure,
+              affinity::Placement placement = affinity::Placement::NONE,
+              QueueArgs&&... queue_args) noexcept
+      : lanes_{Lane{queue_args...}, Lane{queue_args...}, Lane{queue_args...}},
+        backpressure_{backpressure},
+        slaves_count_{slaves_count} {
+    auto cpus{affinity::plan(placement, slaves_count)};
     slaves_.reserve(slaves_count);
     for (auto i : std::views::iota(0ULL, slaves_count)) {
-      slaves_.emplace_back(*this);
+      slaves_.emplace_back(*this, i, std::move(cpus[i]));
     }
   }
 
-  ~Master() noexcept {
+  ~BasicMaster() noexcept {
     for (auto& slave : slaves_) {
       slave.Kill();
     }
+    wake_epoch_.fetch_add(1U);
+    wake_epoch_.notify_all();
   }
 
   template <class F, typename... Args>
+    requires std::invocable<F, Args...>
   auto Run(F&& functor, Args&&... params) noexcept {
-    using functor_return_t = std::invoke_result_t<F, Args...>;
-    std::packaged_task<functor_return_t(Args...)> pack{functor};
-    auto future{pack.get_future()};
-    auto task{
-      [...params = std::forward<Args>(params), pack = std::move(pack)] mutable {
-        pack(std::move(params)...);
+    return Run(Priority::NORMAL, futurama::Cancellation{},
+               std::forward<F>(functor), std::forward<Args>(params)...);
+  }
+
+  template <class F, typename... Args>
+    requires std::invocable<F, Args...>
+  auto Run(Priority priority, F&& functor, Args&&... params) noexcept {
+    return Run(priority, futurama::Cancellation{}, std::forward<F>(functor),
+               std::forward<Args>(params)...);
+  }
+
+  template <class F, typename... Args>
+  auto Run(futurama::Cancellation cancellation, F&& functor,
+           Args&&... params) noexcept {
+    return Run(Priority::NORMAL, std::move(cancellation),
+               std::forward<F>(functor), std::forward<Args>(params)...);
+  }
+
+  // A task still queued once cancellation is due, or once its future has been
+  // cancelled, is dropped when a slave picks it up; its future reports
+  // IsCancelled. See Backpressure for what happens while the pool is full.
+  template <class F, typename... Args>
+  auto Run(Priority priority, futurama::Cancellation cancellation,
+           F&& functor, Args&&... params) noexcept {
+    futurama::Promise<futurama::TASK_RESULT<F, Args...>> promise{};
+    auto future{promise.GetFuture()};
+    auto task{MakeTask(std::move(promise), std::move(cancellation),
+                       std::forward<F>(functor),
+                       std::forward<Args>(params)...)};
+    PushTasks(std::span{&task, 1ULL}, priority);
+
+    return future;
+  }
+
+  // Posts functor(params...) to completions under index once it has run,
+  // instead of returning a future.
+  template <class T, class F, typename... Args>
+  void Run(CompletionQueue<T>& completions, std::size_t index, F&& functor,
+           Args&&... params) noexcept {
+    TaskT task{[&completions, index, functor = std::forward<F>(functor),
+                ... params = std::forward<Args>(params)] mutable {
+      completions.PushFrom(index, std::move(functor), std::move(params)...);
+    }};
+    PushTasks(std::span{&task, 1ULL}, Priority::NORMAL);
+  }
+
+  template <class F, typename... Args>
+    requires std::invocable<F, Args...>
+  auto TrySubmit(F&& functor, Args&&... params) noexcept {
+    return TrySubmit(Priority::NORMAL, std::forward<F>(functor),
+                     std::forward<Args>(params)...);
+  }
+
+  // Never blocks nor runs anything on the calling thread: returns nothing,
+  // leaving functor and params untouched, if the pool is at capacity.
+  template <class F, typename... Args>
+    requires std::invocable<F, Args...>
+  auto TrySubmit(Priority priority, F&& functor, Args&&... params) noexcept
+      -> std::optional<futurama::Future<futurama::TASK_RESULT<F, Args...>>> {
+    if (Admit(1ULL) == 0ULL) return std::nullopt;
+
+    futurama::Promise<futurama::TASK_RESULT<F, Args...>> promise{};
+    auto future{promise.GetFuture()};
+    auto task{MakeTask(std::move(promise), futurama::Cancellation{},
+                       std::forward<F>(functor),
+                       std::forward<Args>(params)...)};
+    Enqueue(std::span{&task, 1ULL}, priority);
+
+    return future;
+  }
+
+  // Submits functor(param) for every element of params with a single push
+  // into the backend and a single round of wake-ups, or as many as the
+  // capacity lets through at a time. Handles are returned in
+  // the order of params. cancellation applies to the whole batch.
+  template <std::ranges::input_range R, class F>
+  auto RunBatch(R&& params, F&& functor,
+                Priority priority = Priority::NORMAL,
+                futurama::Cancellation const& cancellation = {}) {
+    using param_t = std::decay_t<std::ranges::range_reference_t<R>>;
+    using functor_return_t = futurama::TASK_RESULT<F, param_t>;
+
+    std::vector<futurama::Future<functor_return_t>> futures{};
+    std::vector<TaskT> tasks{};
+    if constexpr (std::ranges::sized_range<R>) {
+      futures.reserve(std::ranges::size(params));
+      tasks.reserve(std::ranges::size(params));
+    }
+    for (auto&& param : params) {
+      futurama::Promise<functor_return_t> promise{};
+      futures.push_back(promise.GetFuture());
+      tasks.emplace_back(
+          [param = param_t(std::forward<decltype(param)>(param)), functor,
+           cancellation, promise = std::move(promise)] mutable {
+            promise.SetFromUnlessCancelled(cancellation, functor,
+                                           std::move(param));
+          });
+    }
+    PushTasks(tasks, priority);
+
+    return futures;
+  }
+
+  // Like RunBatch, except that results are posted to completions, tagged with
+  // the position of their param, as soon as they are ready. completions
+  // never holds a task up, but results past its capacity go through its
+  // locked overflow list, so it is best sized to the batch.
+  template <std::ranges::input_range R, class F, class T>
+  void RunBatch(R&& params, F&& functor, CompletionQueue<T>& completions,
+                Priority priority = Priority::NORMAL) {
+    using param_t = std::decay_t<std::ranges::range_reference_t<R>>;
+
+    std::vector<TaskT> tasks{};
+    if constexpr (std::ranges::sized_range<R>) {
+      tasks.reserve(std::ranges::size(params));
+    }
+    for (auto&& param : params) {
+      tasks.emplace_back([param = param_t(std::forward<decltype(param)>(param)),
+                          functor, &completions, index = tasks.size()] mutable {
+        completions.PushFrom(index, functor, std::move(param));
+      });
+    }
+    PushTasks(tasks, priority);
+  }
+
+  // Stores functor(params[i]) in results[i] for every i and returns a future
+  // that becomes ready once all of them are in: the range is cut into
+  // BULK_GRAINS_PER_SLAVE contiguous grains per slave, which a task per
+  // slave claims one after the other from a shared cursor, so that a range
+  // sorted by cost does not leave its heavy grains to a few tasks. The tasks
+  // count down a single latch, so the whole batch costs one shared state
+  // rather than one per element. The future holds the first exception
+  // thrown, if any; the task that threw stops, leaving the rest of its grain
+  // untouched. params and results have to outlive the future becoming ready.
+  template <std::ranges::random_access_range R, class F, class T>
+    requires std::ranges::sized_range<R>
+  futurama::Future<void> RunBulk(R const& params, F functor,
+                                 std::span<T> results,
+                                 Priority priority = Priority::NORMAL) {
+    struct Latch {
+      explicit Latch(std::size_t count) : remaining{count} {}
+
+      void CountDown() noexcept {
+        if (remaining.fetch_sub(1ULL) != 1ULL) return;
+        if (error) {
+          promise.SetException(error);
+        } else {
+          promise.Set();
+        }
       }
+
+      std::atomic<std::size_t> remaining;
+      // Start of the next grain to claim.
+      std::atomic<std::size_t> next_begin{0ULL};
+      std::once_flag error_flag{};
+      std::exception_ptr error{nullptr};
+      futurama::Promise<void> promise{};
     };
-    std::ignore = std::lock_guard{queue_mtx_},
-    remaining_tasks_.push(std::move(task));
 
-    queue_cv_.notify_one();
+    auto const size{gsl::narrow_cast<std::size_t>(std::ranges::size(params))};
+    assert(results.size() >= size);
+    auto const parts_count{std::max<std::size_t>(slaves_count_, 1ULL) *
+                           BULK_GRAINS_PER_SLAVE};
+    auto const grain{
+        std::max<std::size_t>((size + parts_count - 1ULL) / parts_count, 1ULL)};
+    auto const tasks_count{
+        std::min<std::size_t>(std::max<std::size_t>(slaves_count_, 1ULL),
+                              (size + grain - 1ULL) / grain)};
+    auto latch{std::make_shared<Latch>(tasks_count + 1ULL)};
+    auto done{latch->promise.GetFuture()};
 
-    return future;
+    std::vector<TaskT> tasks{};
+    tasks.reserve(tasks_count);
+    for (std::size_t task{0ULL}; task < tasks_count; ++task) {
+      tasks.emplace_back([&params, functor, results, latch, grain, size] {
+        try {
+          for (auto begin{latch->next_begin.fetch_add(grain)}; begin < size;
+               begin = latch->next_begin.fetch_add(grain)) {
+            for (auto i{begin}, end{std::min(begin + grain, size)}; i < end;
+                 ++i) {
+              results[i] = std::invoke(functor, std::ranges::begin(params)[i]);
+            }
+          }
+        } catch (...) {
+          std::call_once(latch->error_flag, [&latch] {
+            latch->error = std::current_exception();
+          });
+        }
+        latch->CountDown();
+      });
+    }
+    PushTasks(tasks, priority);
+    // The extra count makes an empty batch ready right away.
+    latch->CountDown();
+
+    return done;
+  }
+
+  // Fire-and-forget submission; makes the pool a futurama::Scheduler.
+  void Post(TaskT task, Priority priority = Priority::NORMAL) {
+    PushTasks(std::span{&task, 1ULL}, priority);
   }
 
+  // Returns once every task submitted so far has finished, running queued
+  // tasks on the calling thread in the meantime.
   void WaitForAll() {
-    std::unique_lock lk{queue_mtx_};
-    wait_cv_.wait(lk, [&tasks = remaining_tasks_]() { return tasks.empty(); });
+    while (true) {
+      auto const unfinished{unfinished_count_.load()};
+      if (unfinished <= 0) break;
+      if (!RunQueuedTask()) {
+        unfinished_count_.wait(unfinished);
+      }
+    }
+  }
+
+  // Calls functor on every element of range and returns once all calls have
+  // finished. See ParallelTransformReduce for how the range is split.
+  template <class T, class F>
+  void ParallelFor(std::span<T const> range, F&& functor) {
+    std::ignore = ParallelTransformReduce(
+        range, std::monostate{}, [](std::monostate, std::monostate) {
+          return std::monostate{};
+        },
+        [&functor](T const& item) {
+          std::invoke(functor, item);
+          return std::monostate{};
+        });
+  }
+
+  // Reduces transform(item) over range, starting from init, with lazy binary
+  // splitting: the calling thread starts on the whole range and walks it in
+  // SPLIT_GRAIN_SIZE steps; before every step, if the pool has nothing queued
+  // for idle slaves, the upper half of what is left is handed over as a new
+  // task, which splits itself in the same way. Partial results are kept per
+  // slave, so reduce is called without any synchronisation, and are combined
+  // once at the end. The caller runs queued tasks while it waits.
+  template <class T, class R, class Reduce, class Transform>
+  R ParallelTransformReduce(std::span<T const> range, R init, Reduce reduce,
+                            Transform transform) {
+    using Context = SplitContext<T, R, Reduce, Transform>;
+    auto context{std::make_shared<Context>(range, std::move(reduce),
+                                           std::move(transform),
+                                           slaves_count_ + 2ULL)};
+    SplitAndProcess(context, 0ULL, range.size());
+
+    while (true) {
+      auto const remaining{context->remaining.load()};
+      if (remaining == 0ULL) break;
+      if (!RunQueuedTask()) {
+        context->remaining.wait(remaining);
+      }
+    }
+    if (context->error) {
+      std::rethrow_exception(context->error);
+    }
+
+    for (auto& partial : context->partials) {
+      if (partial.value) {
+        init = std::invoke(context->reduce, std::move(init),
+                           std::move(*partial.value));
+      }
+    }
+    return init;
   }
 
  private:
-  std::move_only_function<void()> GetTask(std::stop_token const& st) {
-    std::unique_lock lk{queue_mtx_};
-    queue_cv_.wait(lk, st,
-                   [&tasks = remaining_tasks_]() { return !tasks.empty(); });
-    if (!st.stop_requested()) {
-      auto cur_task{std::move(remaining_tasks_.front())};
-      remaining_tasks_.pop();
-      if (remaining_tasks_.empty()) {
-        wait_cv_.notify_all();
+  template <class T, class F, typename... Args>
+  static TaskT MakeTask(futurama::Promise<T> promise,
+                        futurama::Cancellation cancellation, F&& functor,
+                        Args&&... params) {
+    return TaskT{[... params = std::forward<Args>(params),
+                  functor = std::forward<F>(functor),
+                  cancellation = std::move(cancellation),
+                  promise = std::move(promise)] mutable {
+      promise.SetFromUnlessCancelled(cancellation, std::move(functor),
+                                     std::move(params)...);
+    }};
+  }
+
+  void PushTasks(std::span<TaskT> tasks, Priority priority) {
+    while (!tasks.empty()) {
+      if (auto const admitted{Admit(tasks.size())}; admitted > 0ULL) {
+        Enqueue(tasks.first(admitted), priority);
+        tasks = tasks.subspan(admitted);
+      } else if (backpressure_.policy == OverflowPolicy::CALLER_RUNS) {
+        tasks.front()();
+        tasks = tasks.subspan(1ULL);
+      } else if (this_master_ != this) {
+        WaitForRoom();
+      } else if (!RunQueuedTask()) {
+        // Admitted tasks are on their way into the backend.
+        std::this_thread::yield();
       }
-      return std::move(cur_task);
+    }
+  }
+
+  // Reserves queue room for up to count tasks and returns how many got it.
+  std::size_t Admit(std::size_t count) {
+    if (backpressure_.capacity == 0ULL) return count;
+
+    auto const wanted{gsl::narrow_cast<std::ptrdiff_t>(count)};
+    auto const capacity{
+        gsl::narrow_cast<std::ptrdiff_t>(backpressure_.capacity)};
+    auto admitted_count{admitted_count_.load()};
+    while (admitted_count < capacity) {
+      auto const admitted{std::min(wanted, capacity - admitted_count)};
+      if (admitted_count_.compare_exchange_weak(admitted_count,
+                                                admitted_count + admitted)) {
+        return gsl::narrow_cast<std::size_t>(admitted);
+      }
+    }
+    return 0ULL;
+  }
+
+  // Like Park, a blocked submitter registers before reading the count, and
+  // TasksPopped checks for submitters after lowering it.
+  void WaitForRoom() {
+    blocked_count_.fetch_add(1ULL);
+    auto const admitted_count{admitted_count_.load()};
+    if (admitted_count >=
+        gsl::narrow_cast<std::ptrdiff_t>(backpressure_.capacity)) {
+      admitted_count_.wait(admitted_count);
+    }
+    blocked_count_.fetch_sub(1ULL);
+  }
+
+  // The tasks must have been admitted already.
+  void Enqueue(std::span<TaskT> tasks, Priority priority) {
+    auto const lane_index{std::to_underlying(priority)};
+    auto& lane{lanes_[lane_index]};
+    auto const lane_bit{1U << lane_index};
+    if ((used_lanes_.load(std::memory_order_relaxed) & lane_bit) == 0U) {
+      used_lanes_.fetch_or(lane_bit);
+    }
+    // Counted before the push so that WaitForAll never under-reports.
+    unfinished_count_.fetch_add(std::ssize(tasks));
+    while (!tasks.empty()) {
+      if (auto const pushed{lane.tasks.TryPushBulk(tasks)}; pushed > 0) {
+        tasks = tasks.subspan(pushed);
+        // Queued counts only cover tasks a slave can actually pop, so a woken
+        // slave never spins on a push still in flight. A slave may pop them
+        // before they are counted, which takes the counts below zero for a
+        // moment.
+        auto const published{gsl::narrow_cast<std::ptrdiff_t>(pushed)};
+        lane.queued_count.fetch_add(published);
+        queued_count_.fetch_add(published);
+        WakeSlaves(pushed);
+        continue;
+      }
+      // A bounded backend is full: make room by running a queued task here
+      // rather than waiting on slaves that may themselves be submitting.
+      if (!RunQueuedTask()) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  template <class T, class R, class Reduce, class Transform>
+  struct SplitContext {
+    struct alignas(64) Partial {
+      std::optional<R> value{};
+    };
+
+    SplitContext(std::span<T const> range_init, Reduce reduce_init,
+                 Transform transform_init, std::size_t partials_count)
+        : range{range_init},
+          reduce{std::move(reduce_init)},
+          transform{std::move(transform_init)},
+          partials(partials_count),
+          remaining{range_init.size()} {}
+
+    std::span<T const> range;
+    Reduce reduce;
+    Transform transform;
+    std::vector<Partial> partials;
+    std::atomic<std::size_t> remaining;
+    std::thread::id caller_id{std::this_thread::get_id()};
+    std::mutex foreign_mtx{};
+    std::once_flag error_flag{};
+    std::exception_ptr error{nullptr};
+  };
+
+  template <class Context>
+  void SplitAndProcess(std::shared_ptr<Context> const& context,
+                       std::size_t begin, std::size_t end) {
+    // Slaves and the calling thread own a partial each; any other thread that
+    // ends up here while helping the pool merges its result under a lock.
+    typename Context::Partial foreign_partial{};
+    auto& partial{
+        this_master_ == this ? context->partials[this_slave_id_]
+        : std::this_thread::get_id() == context->caller_id
+            ? context->partials[slaves_count_]
+            : foreign_partial};
+    std::size_t processed{0ULL};
+    try {
+      while (begin < end) {
+        while (end - begin > SPLIT_GRAIN_SIZE && queued_count_.load() <= 0) {
+          auto const middle{begin + (end - begin) / 2ULL};
+          TaskT task{[this, context, middle, end] {
+            SplitAndProcess(context, middle, end);
+          }};
+          PushTasks(std::span{&task, 1ULL}, Priority::NORMAL);
+          end = middle;
+        }
+        auto const step_end{std::min(begin + SPLIT_GRAIN_SIZE, end)};
+        for (auto const& item : context->range.subspan(begin, step_end - begin)) {
+          auto value{std::invoke(context->transform, item)};
+          if (partial.value) {
+            partial.value = std::invoke(
+                context->reduce, std::move(*partial.value), std::move(value));
+          } else {
+            partial.value.emplace(std::move(value));
+          }
+        }
+        processed += step_end - begin;
+        begin = step_end;
+      }
+    } catch (...) {
+      std::call_once(context->error_flag, [&context] {
+        context->error = std::current_exception();
+      });
+      processed += end - begin;
+    }
+    if (foreign_partial.value) {
+      std::lock_guard lk{context->foreign_mtx};
+      auto& shared_partial{context->partials[slaves_count_ + 1ULL]};
+      if (shared_partial.value) {
+        shared_partial.value =
+            std::invoke(context->reduce, std::move(*shared_partial.value),
+                        std::move(*foreign_partial.value));
+      } else {
+        shared_partial.value = std::move(foreign_partial.value);
+      }
+    }
+    // Whatever was split off is counted down by the task that took it over.
+    if (context->remaining.fetch_sub(processed) == processed) {
+      context->remaining.notify_all();
+    }
+  }
+
+  void WakeSlaves(std::size_t tasks_count) {
+    if (sleepers_count_.load() == 0ULL) return;
+
+    wake_epoch_.fetch_add(1U);
+    if (tasks_count >= sleepers_count_.load()) {
+      wake_epoch_.notify_all();
     } else {
-      return {};
+      for (std::size_t i{0ULL}; i < tasks_count; ++i) {
+        wake_epoch_.notify_one();
+      }
+    }
+  }
+
+  std::optional<std::size_t> SelectLane() {
+    auto const used_lanes{used_lanes_.load(std::memory_order_relaxed)};
+    if (std::has_single_bit(used_lanes)) {
+      return gsl::narrow_cast<std::size_t>(std::countr_zero(used_lanes));
+    }
+
+    std::optional<std::size_t> selected{};
+    for (std::size_t i{0ULL}; i < lanes_.size(); ++i) {
+      auto& lane{lanes_[i]};
+      if (lane.queued_count.load() <= 0) continue;
+      if (!selected) {
+        selected = i;
+      } else if (lane.passed_over.load() >= AGING_THRESHOLD) {
+        lane.passed_over.store(0ULL);
+        return i;
+      }
     }
+    return selected;
+  }
+
+  void TasksPopped(std::size_t lane_index, std::size_t count) {
+    if (count == 0ULL) return;
+
+    if (!std::has_single_bit(used_lanes_.load(std::memory_order_relaxed))) {
+      // Every task taken from a higher lane ages the waiting lower ones.
+      for (auto i{lane_index + 1ULL}; i < lanes_.size(); ++i) {
+        if (lanes_[i].queued_count.load() > 0) {
+          lanes_[i].passed_over.fetch_add(count);
+        }
+      }
+    }
+    auto const popped{gsl::narrow_cast<std::ptrdiff_t>(count)};
+    lanes_[lane_index].queued_count.fetch_sub(popped);
+    queued_count_.fetch_sub(popped);
+    if (backpressure_.capacity == 0ULL) return;
+
+    admitted_count_.fetch_sub(popped);
+    if (blocked_count_.load() > 0ULL) {
+      admitted_count_.notify_all();
+    }
+  }
+
+  void TasksFinished(std::size_t count) {
+    auto const finished{gsl::narrow_cast<std::ptrdiff_t>(count)};
+    if (unfinished_count_.fetch_sub(finished) == finished) {
+      unfinished_count_.notify_all();
+    }
+  }
+
+  bool RunQueuedTask() {
+    auto queued_task{PopTask()};
+    if (!queued_task) return false;
+
+    (*queued_task)();
+    TasksFinished(1ULL);
+    return true;
+  }
+
+  std::optional<TaskT> PopTask() {
+    auto const lane_index{SelectLane()};
+    if (!lane_index) return std::nullopt;
+
+    auto task{lanes_[*lane_index].tasks.TryPop()};
+    TasksPopped(*lane_index, task ? 1ULL : 0ULL);
+    return task;
+  }
+
+  std::size_t PopTasks(std::vector<TaskT>& batch, std::size_t max_count) {
+    auto const lane_index{SelectLane()};
+    if (!lane_index) return 0ULL;
+
+    auto const count{lanes_[*lane_index].tasks.TryPopBulk(batch, max_count)};
+    TasksPopped(*lane_index, count);
+    return count;
+  }
+
+  bool GetTasks(std::stop_token const& st, std::vector<TaskT>& batch,
+                BatchSizer const& sizer, AdaptiveWait& waiter) {
+    while (!st.stop_requested()) {
+      auto const batch_size{sizer.Next(queued_count_.load(), slaves_count_)};
+      if (PopTasks(batch, batch_size) > 0ULL) {
+        return true;
+      }
+      waiter.Wait(
+          [this, &st] {
+            return queued_count_.load() > 0 || st.stop_requested();
+          },
+          [this, &st] { Park(st); });
+    }
+    return false;
+  }
+
+  // A sleeper is registered before the epoch is read, and a pusher bumps the
+  // epoch after counting its tasks, so one of them always sees the other.
+  void Park(std::stop_token const& st) {
+    sleepers_count_.fetch_add(1);
+    auto const epoch{wake_epoch_.load()};
+    if (queued_count_.load() <= 0 && !st.stop_requested()) {
+      wake_epoch_.wait(epoch);
+    }
+    sleepers_count_.fetch_sub(1);
   }
 
  private:
-  std::queue<std::move_only_function<void()>> remaining_tasks_{};
+  struct alignas(64) Lane {
+    template <typename... QueueArgs>
+    explicit Lane(QueueArgs&... queue_args) : tasks(queue_args...) {}
+
+    TasksQueue<TaskT> tasks;
+    std::atomic<std::ptrdiff_t> queued_count{0};
+    std::atomic<std::size_t> passed_over{0ULL};
+  };
+
+  static constexpr std::size_t PRIORITIES_COUNT{3ULL};
+  static constexpr std::size_t AGING_THRESHOLD{32ULL};
+  std::array<Lane, PRIORITIES_COUNT> lanes_;
+  std::atomic<unsigned> used_lanes_{0U};
+  Backpressure const backpressure_;
+
+  static constexpr std::size_t SPLIT_GRAIN_SIZE{16ULL};
+  static constexpr std::size_t BULK_GRAINS_PER_SLAVE{8ULL};
+  static inline thread_local BasicMaster* this_master_{nullptr};
+  static inline thread_local std::size_t this_slave_id_{0ULL};
+
+  std::size_t const slaves_count_;
+  // Tasks in the backends, counted once they are in.
+  std::atomic<std::ptrdiff_t> queued_count_{0};
+  // Tasks holding room of a bounded pool, from Admit until popped.
+  std::atomic<std::ptrdiff_t> admitted_count_{0};
+  // Submitted and not finished yet, queued ones included.
+  std::atomic<std::ptrdiff_t> unfinished_count_{0};
+  std::atomic<std::size_t> sleepers_count_{0ULL};
+  // Submitters waiting for room in a full pool.
+  std::atomic<std::size_t> blocked_count_{0ULL};
+  std::atomic<unsigned> wake_epoch_{0U};
 
-  std::condition_variable wait_cv_{};
-  std::mutex queue_mtx_{};
-  std::condition_variable_any queue_cv_{};
   std::vector<Slave> slaves_{};
 };
+
+using Master = BasicMaster<LockedQueue>;
+// Lock-free bounded backend; the constructor takes the ring capacity after
+// the slaves count and the placement. Every lane gets a ring of that
+// capacity, so the pool holds and allocates for PRIORITIES_COUNT times as
+// many tasks; Backpressure is what caps the pool as a whole.
+using RingMaster = BasicMaster<lockfree::RingQueue>;
+
+// Picks between Master and RingMaster where that is a run-time choice.
+enum class Backend { LOCKED, RING };
 }  // namespace multithreading::pool::generic
 
 #endif  // !MULTITHREADING_GENERIC_POOL_HPP
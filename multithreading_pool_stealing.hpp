@@ -1,15 +1,26 @@
 #ifndef MULTITHREADING_POOL_STEALING_HPP
 #define MULTITHREADING_POOL_STEALING_HPP
 
+#include "AdaptiveWait.hpp"
+#include "BatchSizer.hpp"
+#include "InlineTask.hpp"
+#include "LockedQueue.hpp"
+#include "SharedState.hpp"
+#include "StealingDeque.hpp"
+#include "affinity.hpp"
+
 #include <algorithm>
+#include <atomic>
 #include <cassert>
-#include <condition_variable>
+#include <chrono>
 #include <functional>
-#include <future>
 #include <memory>
+#include <mutex>
 #include <optional>
-#include <queue>
+#include <random>
 #include <ranges>
+#include <span>
+#include <system_error>
 #include <thread>
 #include <utility>
 #include <vector>
@@ -18,17 +29,31 @@
 namespace multithreading::pool::stealing {
 struct TaskExecuter;
 
-[[maybe_unused]] TaskExecuter& ThisExecuter([[maybe_unused]] TaskExecuter* init_executer = nullptr) {
-  thread_local TaskExecuter* cur_executer{init_executer};
-  return *cur_executer;
+// The executer of the calling thread: the one owning the slave it runs, or
+// else the innermost TaskExecuter alive that was constructed on it.
+inline TaskExecuter*& ThisExecuterPtr() noexcept {
+  thread_local TaskExecuter* cur_executer{nullptr};
+  return cur_executer;
 }
 
-class Master {
+inline TaskExecuter& ThisExecuter() noexcept { return *ThisExecuterPtr(); }
+
+// A slave that blocks in futurama::Future::Get/Wait is compensated for: a
+// spare slave is unparked, or spawned while fewer than max_spares_count exist,
+// so that target_count slaves keep running. Once the blocked slave is back,
+// the extra spare goes back to park after its current task.
+class Master : private futurama::BlockingObserver {
  private:
+  using TaskT = InlineTask;
+
   class Slave {
    public:
-    Slave(Master& tasks_pool, TaskExecuter* cur_executer) 
+    Slave(Master& tasks_pool, std::size_t id, TaskExecuter* cur_executer,
+          affinity::CPU_LIST cpus, bool is_spare = false)
     : tasks_pool_{tasks_pool},
+      id_{id},
+      cpus_{std::move(cpus)},
+      is_spare_{is_spare},
       cur_thread_{std::bind_front(&Slave::KernelRoutine, this, cur_executer)} {
     }
 
@@ -37,88 +62,314 @@ class Master {
    private:
     void KernelRoutine(TaskExecuter* cur_executer, 
                        std::stop_token const& st) const noexcept {
-      ThisExecuter(cur_executer);
-      while (auto cur_task{tasks_pool_.GetTask(st)}) {
-        cur_task();
-      }
+      affinity::pin_current_thread(cpus_);
+      ThisExecuterPtr() = cur_executer;
+      this_master_ = &tasks_pool_;
+      this_slave_id_ = id_;
+      futurama::ThisThreadObserver() = &tasks_pool_;
+      BatchSizer sizer{};
+      AdaptiveWait waiter{};
+      // A spare starts active and runs until it may retire, then parks until
+      // it is activated again.
+      do {
+        while (auto cur_task{
+                   tasks_pool_.GetTask(st, sizer, waiter, is_spare_)}) {
+          auto const start_time{std::chrono::steady_clock::now()};
+          (*cur_task)();
+          sizer.Record(1ULL, std::chrono::steady_clock::now() - start_time);
+        }
+      } while (is_spare_ && tasks_pool_.AwaitActivation(st));
     }
 
    private:
     Master& tasks_pool_;
+    std::size_t id_;
+    affinity::CPU_LIST cpus_;
+    bool is_spare_;
     std::jthread cur_thread_;
   };
 
  public:
-  Master(std::size_t slaves_count, gsl::not_null<TaskExecuter*> cur_executer) noexcept {
-    slaves_.reserve(slaves_count);
+  static constexpr std::size_t DEFAULT_MAX_SPARES_COUNT{64ULL};
+
+  Master(std::size_t slaves_count, gsl::not_null<TaskExecuter*> cur_executer,
+         affinity::Placement placement = affinity::Placement::NONE,
+         std::size_t max_spares_count = DEFAULT_MAX_SPARES_COUNT) noexcept
+      : cur_executer_{cur_executer},
+        target_count_{gsl::narrow_cast<std::ptrdiff_t>(slaves_count)},
+        max_spares_count_{max_spares_count},
+        active_count_{target_count_},
+        victims_count_{slaves_count} {
+    // Every deque, spares' included, has to exist before the first slave
+    // starts stealing.
+    deques_.reserve(slaves_count + max_spares_count);
+    std::generate_n(std::back_inserter(deques_),
+                    slaves_count + max_spares_count, [] {
+      return std::make_unique<lockfree::StealingDeque<TaskT>>();
+    });
+    auto cpus{affinity::plan(placement, slaves_count)};
+    // Slaves are never moved: their threads hold on to them.
+    slaves_.reserve(slaves_count + max_spares_count);
     for (auto i : std::views::iota(0ULL, slaves_count)) {
-      slaves_.emplace_back(*this, cur_executer);
+      slaves_.emplace_back(*this, i, cur_executer, std::move(cpus[i]));
     }
   }
 
   ~Master() noexcept {
+    {
+      // No spare may be spawned once the slaves are being killed.
+      std::lock_guard lk{spares_mtx_};
+      dying_ = true;
+    }
     for (auto& slave : slaves_) {
       slave.Kill();
     }
+    WakeAll();
+    spare_activations_.fetch_add(1ULL);
+    spare_activations_.notify_all();
+    slaves_.clear();
+    for (auto& deque : deques_) {
+      while (std::unique_ptr<TaskT> abandoned{deque->Pop()}) {
+      }
+    }
   }
 
+  // Takes an optional futurama::Cancellation first: a task still queued once
+  // it is due, or once its future has been cancelled, is dropped.
   template <class F, typename... Args>
   auto Dispatch(F&& functor, Args&&... params) noexcept {
-    using functor_return_t = std::invoke_result_t<F, Args...>;
-    std::packaged_task<functor_return_t(Args...)> pack{functor};
-    auto future{pack.get_future()};
-    auto task{[... params = std::forward<Args>(params),
-               pack = std::move(pack)] mutable { pack(std::move(params)...); }};
-    std::ignore = std::lock_guard{queue_mtx_},
-    remaining_tasks_.push(std::move(task));
-
-    queue_cv_.notify_one();
-
-    return future;
+    return futurama::Async(*this, std::forward<F>(functor),
+                           std::forward<Args>(params)...);
   }
 
+  // Fire-and-forget submission; makes the pool a futurama::Scheduler.
+  void Post(TaskT task) { Push(std::move(task)); }
+
  private:
-  std::move_only_function<void()> GetTask(std::stop_token const& st) {
-    std::unique_lock lk{queue_mtx_};
-    queue_cv_.wait(lk, st,
-                   [&tasks = remaining_tasks_]() { return !tasks.empty(); });
-    if (!st.stop_requested()) {
-      auto cur_task{std::move(remaining_tasks_.front())};
-      remaining_tasks_.pop();
-      return cur_task;
+  // Deques hold their tasks on the heap, allocated by the pushing slave from
+  // its own cache; the injection queue holds them by value.
+  void Push(TaskT task) {
+    if (this_master_ == this) {
+      deques_[this_slave_id_]->Push(new TaskT{std::move(task)});
     } else {
-      return {};
+      injected_tasks_.TryPushBulk(std::span{&task, 1ULL});
+      injected_count_.fetch_add(1);
+    }
+    pending_count_.fetch_add(1);
+
+    if (sleepers_count_.load() > 0) {
+      wake_epoch_.fetch_add(1U);
+      wake_epoch_.notify_one();
+    }
+  }
+
+  void BlockingStarted() noexcept override {
+    if (active_count_.fetch_sub(1) - 1 >= target_count_) return;
+
+    // A parked spare is preferred; every parked one is counted as idle and
+    // an activation granted here is taken by exactly one of them.
+    auto idle{idle_spares_count_.load()};
+    while (idle > 0ULL) {
+      if (idle_spares_count_.compare_exchange_weak(idle, idle - 1ULL)) {
+        active_count_.fetch_add(1);
+        spare_activations_.fetch_add(1ULL);
+        spare_activations_.notify_one();
+        return;
+      }
+    }
+    std::lock_guard lk{spares_mtx_};
+    auto const id{victims_count_.load()};
+    if (dying_ || id - gsl::narrow_cast<std::size_t>(target_count_) >=
+                      max_spares_count_) {
+      return;
+    }
+    try {
+      slaves_.emplace_back(*this, id, cur_executer_, affinity::CPU_LIST{},
+                           true);
+    } catch (std::system_error const&) {
+      // Out of threads: the pool just runs one slave short for a while.
+      return;
+    }
+    active_count_.fetch_add(1);
+    // Spare deques exist already: publishing one more victim is enough.
+    victims_count_.store(id + 1ULL);
+  }
+
+  void BlockingFinished() noexcept override {
+    if (active_count_.fetch_add(1) + 1 > target_count_) {
+      // Parked active spares have to notice they may retire.
+      WakeAll();
+    }
+  }
+
+  // Called by a spare with nothing in its own deque.
+  bool TryRetire() noexcept {
+    auto active{active_count_.load()};
+    while (active > target_count_) {
+      if (active_count_.compare_exchange_weak(active, active - 1)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool AwaitActivation(std::stop_token const& st) {
+    idle_spares_count_.fetch_add(1ULL);
+    while (!st.stop_requested()) {
+      auto activations{spare_activations_.load()};
+      if (activations > 0ULL) {
+        if (spare_activations_.compare_exchange_weak(activations,
+                                                     activations - 1ULL)) {
+          return true;
+        }
+        continue;
+      }
+      spare_activations_.wait(activations);
+    }
+    return false;
+  }
+
+  std::unique_ptr<TaskT> GetTask(std::stop_token const& st,
+                                 BatchSizer const& sizer,
+                                 AdaptiveWait& waiter, bool is_spare) {
+    while (!st.stop_requested()) {
+      if (is_spare && deques_[this_slave_id_]->Empty() && TryRetire()) {
+        return {};
+      }
+      auto const batch_size{sizer.Next(
+          gsl::narrow_cast<std::ptrdiff_t>(injected_count_.load()),
+          deques_.size())};
+      if (auto task{FindTask(batch_size)}) {
+        return task;
+      }
+      auto const done{[this, &st, is_spare] {
+        return st.stop_requested() ||
+               (is_spare && active_count_.load() > target_count_);
+      }};
+      waiter.Wait([this, &done] { return pending_count_.load() > 0 || done(); },
+                  [this, &done] { Park(done); });
     }
+    return {};
+  }
+
+  // A sleeper is registered before the epoch is read, and a pusher bumps the
+  // epoch after counting its task, so one of them always sees the other. The
+  // same holds for whoever makes done() true and then calls WakeAll.
+  template <class Done>
+  void Park(Done&& done) {
+    sleepers_count_.fetch_add(1);
+    auto const epoch{wake_epoch_.load()};
+    if (pending_count_.load() <= 0 && !done()) {
+      wake_epoch_.wait(epoch);
+    }
+    sleepers_count_.fetch_sub(1);
+  }
+
+  void WakeAll() noexcept {
+    wake_epoch_.fetch_add(1U);
+    wake_epoch_.notify_all();
+  }
+
+  // A slave takes up to batch_size tasks from the injection queue at once:
+  // the first one is returned, the rest go to its own deque, where idle slaves
+  // can still steal them.
+  std::unique_ptr<TaskT> FindTask(std::size_t batch_size = 1ULL) {
+    auto const is_own{this_master_ == this};
+    if (is_own) {
+      if (std::unique_ptr<TaskT> task{deques_[this_slave_id_]->Pop()}) {
+        pending_count_.fetch_sub(1);
+        return task;
+      }
+    }
+    if (injected_count_.load(std::memory_order_relaxed) > 0) {
+      thread_local std::vector<TaskT> injected_batch{};
+      if (auto const count{injected_tasks_.TryPopBulk(
+              injected_batch, is_own ? batch_size : 1ULL)};
+          count > 0ULL) {
+        injected_count_.fetch_sub(count);
+        for (auto& extra_task : injected_batch | std::views::drop(1)) {
+          deques_[this_slave_id_]->Push(new TaskT{std::move(extra_task)});
+        }
+        auto task{std::make_unique<TaskT>(std::move(injected_batch.front()))};
+        injected_batch.clear();
+        pending_count_.fetch_sub(1);
+        return task;
+      }
+    }
+
+    thread_local std::minstd_rand rng{std::random_device{}()};
+    auto const victims_count{victims_count_.load()};
+    auto const first_victim{std::uniform_int_distribution<std::size_t>{
+        0ULL, victims_count - 1ULL}(rng)};
+    for (auto i : std::views::iota(0ULL, victims_count)) {
+      auto const victim{(first_victim + i) % victims_count};
+      if (is_own && victim == this_slave_id_) continue;
+      if (std::unique_ptr<TaskT> task{deques_[victim]->Steal()}) {
+        pending_count_.fetch_sub(1);
+        return task;
+      }
+    }
+    return {};
   }
 
   template <class F>
-  friend auto SyncOn(F&& future) -> decltype(std::declval<F>().get());
+  friend auto SyncOn(F&& future) -> decltype(std::declval<F>().Get());
 
-  void TryTask() {
-    if (std::unique_lock lk{queue_mtx_}; !remaining_tasks_.empty()) {
-      auto task{std::move(remaining_tasks_.front())};
-      remaining_tasks_.pop();
-      lk.unlock();
-      task();
+  bool TryTask() {
+    if (auto task{FindTask()}) {
+      (*task)();
+      return true;
     }
+    return false;
   }
 
  private:
-  std::queue<std::move_only_function<void()>> remaining_tasks_{};
+  static inline thread_local Master* this_master_{nullptr};
+  static inline thread_local std::size_t this_slave_id_{0ULL};
+
+  std::vector<std::unique_ptr<lockfree::StealingDeque<TaskT>>> deques_{};
 
-  std::mutex queue_mtx_{};
-  std::condition_variable_any queue_cv_{};
+  LockedQueue<TaskT> injected_tasks_{};
+  std::atomic<std::size_t> injected_count_{0ULL};
+
+  TaskExecuter* const cur_executer_;
+  std::ptrdiff_t const target_count_;
+  std::size_t const max_spares_count_;
+  std::atomic<std::ptrdiff_t> active_count_;
+  std::atomic<std::size_t> victims_count_;
+  std::atomic<std::size_t> idle_spares_count_{0ULL};
+  std::atomic<std::size_t> spare_activations_{0ULL};
+  std::mutex spares_mtx_{};
+  bool dying_{false};
+
+  std::atomic<std::ptrdiff_t> pending_count_{0};
+  std::atomic<std::size_t> sleepers_count_{0ULL};
+  std::atomic<unsigned> wake_epoch_{0U};
   std::vector<Slave> slaves_{};
 };
 
+// Only the process queue is placed: async slaves mostly wait, and spares come
+// and go with blocking. While alive, it is ThisExecuter of the thread that
+// constructed it, and the previous one is restored once it is gone.
 struct TaskExecuter {
-  TaskExecuter(std::size_t async_cores_count, std::size_t process_cores_count)
+  TaskExecuter(std::size_t async_cores_count, std::size_t process_cores_count,
+               affinity::Placement placement = affinity::Placement::NONE)
       : async_queue{async_cores_count, this},
-        process_queue{process_cores_count, this}
-  { std::ignore = ThisExecuter(this); }
+        process_queue{process_cores_count, this, placement},
+        previous_executer_{std::exchange(ThisExecuterPtr(), this)} {}
+
+  TaskExecuter(TaskExecuter const&) = delete;
+  TaskExecuter& operator=(TaskExecuter const&) = delete;
+
+  ~TaskExecuter() {
+    if (ThisExecuterPtr() == this) ThisExecuterPtr() = previous_executer_;
+  }
 
   Master async_queue;
   Master process_queue;
+
+ private:
+  TaskExecuter* const previous_executer_;
 };
 
 template <class F, typename... Args>
@@ -133,13 +384,29 @@ inline auto RunProcessTask(F&& functor, Args&&... params) {
                                                std::forward<Args>(params)...);
 }
 
+// Helps the async queue until future is ready. With nothing to help with it
+// waits adaptively and parks alongside the async slaves, to be woken by a new
+// task or by the future itself, whose wake-up is registered with OnReady
+// next to any continuations future already has.
 template <class F>
-inline auto SyncOn(F&& future) -> decltype(std::declval<F>().get()) {
-  using namespace std::chrono_literals;
-  while (future.wait_for(0s) != std::future_status::ready) {
-    ThisExecuter().async_queue.TryTask();
+inline auto SyncOn(F&& future) -> decltype(std::declval<F>().Get()) {
+  thread_local AdaptiveWait waiter{};
+  auto& async_queue{ThisExecuter().async_queue};
+  auto wake_armed{false};
+  while (!future.IsReady()) {
+    if (async_queue.TryTask()) continue;
+    waiter.Wait(
+        [&future, &async_queue] {
+          return async_queue.pending_count_.load() > 0 || future.IsReady();
+        },
+        [&future, &async_queue, &wake_armed] {
+          if (!std::exchange(wake_armed, true)) {
+            future.OnReady([&async_queue] { async_queue.WakeAll(); });
+          }
+          async_queue.Park([&future] { return future.IsReady(); });
+        });
   }
-  return future.get();
+  return future.Get();
 }
 }  // namespace multithreading::pool::stealing
 
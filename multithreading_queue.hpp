@@ -3,25 +3,148 @@
 
 #include "Job.hpp"
 #include "StatisticChunk.hpp"
+#include "affinity.hpp"
+#include "dispatch_order.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <gsl/gsl>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
 
 namespace config {
 using CHUNK_VIEW = std::span<Job const>;
-using SLAVE_TASK = CHUNK_VIEW::const_iterator;
+using SLAVE_TASKS = CHUNK_VIEW;
 }  // namespace config
 
 namespace multithreading::queue {
+// How many tasks one get_tasks call claims (N - chunk size, R - tasks still
+// unclaimed, P - slaves count):
+// SINGLE      - one task per call;
+// FIXED_CHUNK - a constant number of tasks;
+// GUIDED      - ceil(R / P) (Polychronopoulos & Kuck);
+// FACTORING   - batches of P equal slices, each batch taking half of what was
+//               left: ceil(N / (2^(b+1) * P)) for batch b (Hummel et al.);
+// TRAPEZOID   - sizes falling linearly from N / (2P) down to 1 (Tzen & Ni).
+enum class DispensingPolicy { SINGLE, FIXED_CHUNK, GUIDED, FACTORING, TRAPEZOID };
+
+// Dispensing state of one chunk: hands out slices of it to the slaves as the
+// DispensingPolicy of the master says.
+class Workload {
+ public:
+  void load(config::CHUNK_VIEW new_workload, dispatch_order::Order order,
+            DispensingPolicy policy_init, gsl::index fixed_chunk_size_init,
+            std::size_t slaves_count_init) {
+    if (order == dispatch_order::Order::LARGEST_FIRST) {
+      ordered_workload = dispatch_order::largest_first(new_workload);
+      new_workload = ordered_workload;
+    }
+    policy = policy_init;
+    fixed_chunk_size = fixed_chunk_size_init;
+    slaves_count = gsl::narrow_cast<gsl::index>(slaves_count_init);
+    cur_workload = new_workload;
+    cur_task = 0;
+    dispensed_slices = 0;
+
+    auto const total{gsl::narrow_cast<double>(cur_workload.size())};
+    auto const slaves{gsl::narrow_cast<double>(slaves_count)};
+    trapezoid_first = std::max(std::floor(total / (2. * slaves)), 1.);
+    auto const slices_count{std::ceil(2. * total / (trapezoid_first + 1.))};
+    trapezoid_step =
+        slices_count > 1. ? (trapezoid_first - 1.) / (slices_count - 1.) : 0.;
+  }
+
+  std::optional<config::SLAVE_TASKS> get_tasks() {
+    auto const total{gsl::narrow_cast<gsl::index>(cur_workload.size())};
+    gsl::index first{};
+    gsl::index count{};
+    switch (policy) {
+      case DispensingPolicy::SINGLE:
+      case DispensingPolicy::FIXED_CHUNK:
+        count = policy == DispensingPolicy::SINGLE ? 1 : fixed_chunk_size;
+        first = cur_task.fetch_add(count);
+        break;
+      case DispensingPolicy::GUIDED:
+        first = cur_task.load();
+        do {
+          if (first >= total) return std::nullopt;
+          count = (total - first + slaves_count - 1) / slaves_count;
+        } while (!cur_task.compare_exchange_weak(first, first + count));
+        break;
+      case DispensingPolicy::FACTORING:
+      case DispensingPolicy::TRAPEZOID:
+        count = slice_size(dispensed_slices++, total);
+        first = cur_task.fetch_add(count);
+        break;
+    }
+    if (first >= total) return std::nullopt;
+    return cur_workload.subspan(gsl::narrow_cast<std::size_t>(first),
+                                gsl::narrow_cast<std::size_t>(
+                                    std::min(count, total - first)));
+  }
+
+  bool is_exhausted() const {
+    return cur_task >= gsl::narrow_cast<gsl::index>(cur_workload.size());
+  }
+
+ private:
+  gsl::index slice_size(gsl::index slice, gsl::index total) const {
+    if (policy == DispensingPolicy::FACTORING) {
+      auto const batch{std::min(slice / slaves_count, gsl::index{32})};
+      auto const divisor{(gsl::index{2} << batch) * slaves_count};
+      return std::max((total + divisor - 1) / divisor, gsl::index{1});
+    } else {
+      return std::max(
+          gsl::narrow_cast<gsl::index>(std::llround(
+              trapezoid_first - trapezoid_step * gsl::narrow_cast<double>(slice))),
+          gsl::index{1});
+    }
+  }
+
+ private:
+  DispensingPolicy policy{DispensingPolicy::SINGLE};
+  gsl::index fixed_chunk_size{1};
+  gsl::index slaves_count{1};
+
+  std::vector<Job> ordered_workload{};
+  config::CHUNK_VIEW cur_workload{};
+  std::atomic<gsl::index> cur_task{};
+  std::atomic<gsl::index> dispensed_slices{};
+  double trapezoid_first{};
+  double trapezoid_step{};
+};
+
+struct ChunkReport {
+  StatisticChunk stats;
+  Task::DUMMY_OUTPUT output{};
+};
+
 class Master {
  public:
+  static constexpr std::size_t DEFAULT_FIXED_CHUNK_SIZE{32ULL};
+
+  explicit Master(std::size_t slaves_count_init,
+                  DispensingPolicy policy_init = DispensingPolicy::SINGLE,
+                  std::size_t fixed_chunk_size_init = DEFAULT_FIXED_CHUNK_SIZE)
+      : slaves_count{slaves_count_init},
+        policy{policy_init},
+        fixed_chunk_size{gsl::narrow_cast<gsl::index>(
+            std::max(fixed_chunk_size_init, std::size_t{1}))} {}
+
   void job_is_done() {
     bool notification_needed{false};
     {
       std::lock_guard lock{mtx};
       ++slaves_finished_job_count;
-      notification_needed = slaves_finished_job_count == config::SLAVES_COUNT;
+      notification_needed = slaves_finished_job_count == slaves_count;
     }
     if (notification_needed) {
       cv.notify_one();
@@ -30,45 +153,178 @@ class Master {
 
   void wait_for_slaves() {
     cv.wait(lock, [this] {
-      return slaves_finished_job_count == config::SLAVES_COUNT;
+      return slaves_finished_job_count == slaves_count;
     });
     slaves_finished_job_count = 0ull;
-    assert(cur_task >= gsl::narrow_cast<gsl::index>(cur_workload.size()));
+    assert(workload.is_exhausted());
   }
 
-  void add_workload(config::CHUNK_VIEW new_workload) {
-    cur_workload = new_workload;
-    cur_task = 0;
+  void add_workload(config::CHUNK_VIEW new_workload,
+                    dispatch_order::Order order =
+                        dispatch_order::Order::AS_GENERATED) {
+    workload.load(new_workload, order, policy, fixed_chunk_size, slaves_count);
+  }
+
+  std::optional<config::SLAVE_TASKS> get_tasks() {
+    return workload.get_tasks();
+  }
+
+  // Pipelined mode. Up to lookahead chunks past the oldest unfinished one are
+  // kept queued, and a slave that finds nothing left to claim in a chunk moves
+  // on to the next one instead of waiting for the others to finish. Call it
+  // before chunk_load on the slaves; they come back through job_is_done once
+  // the pipeline is closed and drained.
+  void start_pipeline(std::size_t lookahead) {
+    window = lookahead + 1ULL;
+    slots = std::make_unique<ChunkSlot[]>(window);
+    for (auto& slot : std::span{slots.get(), window}) {
+      slot.stats = StatisticChunk{slaves_count};
+      slot.arrival_times.resize(slaves_count);
+      slot.departure_times.resize(slaves_count);
+      slot.outputs.resize(slaves_count);
+    }
+    pipeline_slaves_count = 0ULL;
+    loaded_count = 0ULL;
+    collected_count = 0ULL;
+    pipeline_closed = false;
+  }
+
+  bool is_pipelined() const { return window > 0ULL; }
+
+  // No chunk may be pushed while this holds; pop_finished makes room.
+  bool is_window_full() const {
+    return loaded_count.load() - collected_count == window;
   }
 
-  std::optional<config::SLAVE_TASK> get_task() {
-    auto const old_task{cur_task++};
-    if (old_task >= gsl::narrow_cast<gsl::index>(cur_workload.size())) return std::nullopt;
-    return cur_workload.cbegin() + old_task;
+  void push_workload(config::CHUNK_VIEW new_workload,
+                     dispatch_order::Order order =
+                         dispatch_order::Order::AS_GENERATED) {
+    assert(!is_window_full());
+    auto const number{loaded_count.load()};
+    auto& slot{slots[number % window]};
+    slot.workload.load(new_workload, order, policy, fixed_chunk_size,
+                       slaves_count);
+    std::ranges::fill(slot.arrival_times,
+                      std::chrono::steady_clock::time_point{});
+    slot.departed_count = 0ULL;
+    loaded_count.store(number + 1ULL);
+    pipeline_epoch.fetch_add(1ULL);
+    pipeline_epoch.notify_all();
+  }
+
+  void close_pipeline() {
+    pipeline_closed = true;
+    pipeline_epoch.fetch_add(1ULL);
+    pipeline_epoch.notify_all();
+  }
+
+  // Waits for the oldest chunk not collected yet to be finished by every
+  // slave; nullopt once there is none.
+  std::optional<ChunkReport> pop_finished() {
+    if (collected_count == loaded_count.load()) return std::nullopt;
+
+    auto& slot{slots[collected_count % window]};
+    for (auto departed{slot.departed_count.load()}; departed < slaves_count;
+         departed = slot.departed_count.load()) {
+      slot.departed_count.wait(departed);
+    }
+    ++collected_count;
+
+    ChunkReport report{.stats = slot.stats};
+    for (auto const output : slot.outputs) {
+      report.output += output;
+    }
+    report.stats.total_timing =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::ranges::max(slot.departure_times) -
+            std::ranges::min(slot.arrival_times))
+            .count();
+    return report;
+  }
+
+  // For slaves in pipelined mode: the column of the stats a slave fills in.
+  std::size_t join_pipeline() { return pipeline_slaves_count.fetch_add(1ULL); }
+
+  // Waits until chunk number is loaded; false once the pipeline is closed
+  // and every chunk has been visited.
+  bool wait_for_workload(std::size_t number) {
+    while (true) {
+      auto const epoch{pipeline_epoch.load()};
+      if (number < loaded_count.load()) return true;
+      if (pipeline_closed) return false;
+      pipeline_epoch.wait(epoch);
+    }
+  }
+
+  std::optional<config::SLAVE_TASKS> get_tasks(std::size_t number,
+                                               std::size_t slave_id) {
+    auto& slot{slots[number % window]};
+    if (slot.arrival_times[slave_id] == std::chrono::steady_clock::time_point{}) {
+      slot.arrival_times[slave_id] = std::chrono::steady_clock::now();
+    }
+    return slot.workload.get_tasks();
+  }
+
+  // Called once per slave and chunk, after its last claim on the chunk came
+  // back empty, so the chunk is finished once every slave has left it.
+  void leave_workload(std::size_t number, std::size_t slave_id,
+                      Task::DUMMY_OUTPUT output, long long work_time_elapsed,
+                      std::size_t heavy_jobs_count) {
+    auto& slot{slots[number % window]};
+    slot.outputs[slave_id] = output;
+    slot.stats.timing_per_thread[slave_id] = work_time_elapsed;
+    slot.stats.number_of_heavy_jobs_per_thread[slave_id] = heavy_jobs_count;
+    slot.departure_times[slave_id] = std::chrono::steady_clock::now();
+    if (slot.departed_count.fetch_add(1ULL) + 1ULL == slaves_count) {
+      slot.departed_count.notify_all();
+    }
   }
 
  private:
+  struct ChunkSlot {
+    Workload workload{};
+    StatisticChunk stats{0ULL};
+    std::vector<Task::DUMMY_OUTPUT> outputs{};
+    std::vector<std::chrono::steady_clock::time_point> arrival_times{};
+    std::vector<std::chrono::steady_clock::time_point> departure_times{};
+    std::atomic<std::size_t> departed_count{0ULL};
+  };
+
   std::condition_variable cv{};
   std::mutex mtx{};
   std::unique_lock<std::mutex> lock{mtx};
 
-  config::CHUNK_VIEW cur_workload{};
-  std::atomic<gsl::index> cur_task{};
+  std::size_t const slaves_count;
+  DispensingPolicy const policy;
+  gsl::index const fixed_chunk_size;
+
+  Workload workload{};
+
+  std::size_t window{0ULL};
+  std::unique_ptr<ChunkSlot[]> slots{};
+  std::atomic<std::size_t> pipeline_slaves_count{0ULL};
+  std::atomic<std::size_t> loaded_count{0ULL};
+  std::atomic<std::size_t> pipeline_epoch{0ULL};
+  std::atomic<bool> pipeline_closed{false};
+  std::size_t collected_count{0ULL};
 
   std::size_t slaves_finished_job_count{0ull};
 };
 
 class Slave {
  public:
-  Slave(Master& control_block_init)
-      : control_block{control_block_init}, process{&Slave::run, this} {}
+  Slave(Master& control_block_init, affinity::CPU_LIST cpus_init = {})
+      : cpus{std::move(cpus_init)},
+        control_block{control_block_init},
+        process{&Slave::run, this} {}
 
-  Slave(Slave&& slave_tmp) noexcept : Slave{slave_tmp.control_block} {}
+  Slave(Slave&& slave_tmp) noexcept
+      : Slave{slave_tmp.control_block, slave_tmp.cpus} {}
 
   ~Slave() { kill(); }
 
   void chunk_load() {
-    chunk_loaded = true;
+    std::ignore = std::lock_guard{mtx}, chunk_loaded = true;
     cv.notify_one();
   }
 
@@ -85,6 +341,7 @@ class Slave {
 
  private:
   void run() {
+    affinity::pin_current_thread(cpus);
     std::unique_lock lock{mtx};
 
     while (true) {
@@ -92,21 +349,10 @@ class Slave {
 
       if (dying) break;
 
-      heavy_jobs_count = 0ll;
-      output = Task::DUMMY_OUTPUT{0};
-      work_time_elapsed = 0;
-      for (auto cur_task{control_block.get_task()}; cur_task.has_value();
-           cur_task = control_block.get_task()) {
-        auto const start_time_data{std::chrono::steady_clock::now()};
-        output += cur_task.value()->task->do_stuff();
-        auto const end_time_data{std::chrono::steady_clock::now()};
-        work_time_elapsed +=
-            std::chrono::duration_cast<std::chrono::milliseconds>(
-                end_time_data - start_time_data)
-                .count();
-
-        if (typeid(*(cur_task.value()->task.get())) == typeid(HeavyTask const&))
-          ++heavy_jobs_count;
+      if (control_block.is_pipelined()) {
+        run_pipeline();
+      } else {
+        process_workload([this] { return control_block.get_tasks(); });
       }
 
       chunk_loaded = false;
@@ -114,11 +360,46 @@ class Slave {
     }
   }
 
+  void run_pipeline() {
+    auto const id{control_block.join_pipeline()};
+    for (std::size_t number{0ULL}; control_block.wait_for_workload(number);
+         ++number) {
+      process_workload(
+          [this, number, id] { return control_block.get_tasks(number, id); });
+      control_block.leave_workload(number, id, output, work_time_elapsed,
+                                   heavy_jobs_count);
+    }
+  }
+
+  template <class GetTasks>
+  void process_workload(GetTasks get_tasks) {
+    heavy_jobs_count = 0ll;
+    output = Task::DUMMY_OUTPUT{0};
+    work_time_elapsed = 0;
+    for (auto cur_tasks{get_tasks()}; cur_tasks.has_value();
+         cur_tasks = get_tasks()) {
+      auto const start_time_data{std::chrono::steady_clock::now()};
+      for (auto const& dummy_process : cur_tasks.value()) {
+        output += dummy_process.task->do_stuff();
+      }
+      auto const end_time_data{std::chrono::steady_clock::now()};
+      work_time_elapsed +=
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              end_time_data - start_time_data)
+              .count();
+
+      for (auto const& dummy_process : cur_tasks.value()) {
+        if (typeid(*dummy_process.task.get()) == typeid(HeavyTask const&))
+          ++heavy_jobs_count;
+      }
+    }
+  }
+
  private:
   std::condition_variable cv{};
   std::mutex mtx{};
 
-  std::jthread process;
+  affinity::CPU_LIST const cpus;
 
   Master& control_block;
   Task::DUMMY_OUTPUT output{};
@@ -128,6 +409,9 @@ class Slave {
 
   long long work_time_elapsed{};
   std::size_t heavy_jobs_count{};
+
+  // Started last, once everything run() touches is initialised.
+  std::jthread process;
 };
 
 }  // namespace multithreading::queue